@@ -0,0 +1,130 @@
+﻿
+# include <Siv3D.hpp> // OpenSiv3D v0.6.3
+
+//GPUの無い環境でも動くように描画はヘッドレスのレンダラーに流す(描画命令は積まれるだけでGPUへは出ない)
+SIV3D_SET(EngineOption::Renderer::Headless)
+
+# include "XMasScene.hpp"
+
+# define PIXIEALLOC_IMPLEMENTATION
+# include "PixieAlloc.hpp"
+
+# if defined(_WIN32)
+#	include <Siv3D/Windows/Windows.hpp>
+#	include <Psapi.h>
+# else
+#	include <sys/resource.h>
+# endif
+
+//ヘッドレスの性能計測。Main.cpp と同じシーンを固定の種と固定刻みでNフレーム進め、読み込み/焼き込み/区間毎の時間と最大メモリを出す
+//引数: --frames N  --seed S  --threads N(run()を呼ぶスレッド以外のワーカー数)  --assets パス  --trace 出力先(Chromeのトレース形式)
+
+//プロセスの最大常駐メモリ(バイト)
+static uint64 PeakMemoryBytes()
+{
+# if defined(_WIN32)
+	PROCESS_MEMORY_COUNTERS pmc{};
+	if (::GetProcessMemoryInfo(::GetCurrentProcess(), &pmc, sizeof(pmc))) return pmc.PeakWorkingSetSize;
+	return 0;
+# else
+	rusage ru{};
+	if (::getrusage(RUSAGE_SELF, &ru) == 0) return (uint64)ru.ru_maxrss * 1024;	//Linuxはキロバイト単位
+	return 0;
+# endif
+}
+
+static double TotalOf(const Array<PixieProfiler::Stat>& stats, StringView name)
+{
+	for (const auto& stat : stats)
+	{
+		if (stat.name == name) return stat.avg * stat.frames;
+	}
+	return 0;
+}
+
+void Main()
+{
+	int32 frames = 600;
+	uint64 seed = 2021;
+	size_t threads = Max(1u, std::thread::hardware_concurrency()) - 1;
+	String assetPath{ APATH };
+	String tracePath;
+
+	const Array<String> args = System::GetCommandLineArgs();
+	for (size_t i = 1; i + 1 < args.size(); i += 2)
+	{
+		const String& key = args[i];
+		const String& value = args[i + 1];
+		if		(key == U"--frames")  frames = Max(1, ParseOr<int32>(value, frames));
+		else if (key == U"--seed")	  seed = ParseOr<uint64>(value, seed);
+		else if (key == U"--threads") threads = ParseOr<size_t>(value, threads);
+		else if (key == U"--assets")  assetPath = value;
+		else if (key == U"--trace")	  tracePath = value;
+	}
+
+	//読み込みと焼き込みも計る。統計とトレースは全フレーム分残す
+	PixieProfiler::SetEnabled(true, frames + 1);
+
+	XMasScene scene;
+	Stopwatch stopwatch{ StartImmediately::Yes };
+	scene.load(assetPath);
+	scene.setup(seed);
+	const double setupTime = stopwatch.msF();
+	PixieProfiler::NextFrame();						//読み込みまでを1フレーム目として確定
+
+	//固定刻みで1フレーム1ティック進める。描画はメインとPiPの両ビュー
+	PixieJobs jobs(threads);
+	const double step = scene.scheduler.getStepTime();
+
+	PixieAlloc::NextFrame();
+	uint64 allocCount = 0, allocBytes = 0;
+	uint64 culled = 0;
+
+	stopwatch.restart();
+	for (int32 f = 0; f < frames; f++)
+	{
+		PixieMesh::resetCullStats();
+		{
+			PIXIE_PROFILE("Benchmark::frame");
+			scene.update(jobs, step);
+			scene.updateVisibility(jobs);
+			{
+				PIXIE_PROFILE("Benchmark::drawMain");
+				scene.draw(VIEWMAIN);
+			}
+			{
+				PIXIE_PROFILE("Benchmark::drawPiP");
+				scene.draw(VIEWPIP);
+			}
+		}
+		PixieProfiler::NextFrame();
+
+		PixieAlloc::NextFrame();
+		allocCount += PixieAlloc::PerFrame();
+		allocBytes += PixieAlloc::BytesPerFrame();
+		culled += PixieMesh::culledCount;
+	}
+	const double runTime = stopwatch.msF();
+
+	const Array<PixieProfiler::Stat> stats = PixieProfiler::GetStats();
+
+	Console << U"TestXMas benchmark  frames:{} seed:{} threads:{} ticks:{}"_fmt(frames, seed, jobs.num_workers() - 1, scene.scheduler.getTickCount());
+	Console << U"setup   : {:.1f} ms (load {:.1f} ms, bake {:.1f} ms, LOD {:.1f} ms)"_fmt(
+		setupTime, TotalOf(stats, U"PixieMesh::load"), TotalOf(stats, U"PixieMesh::bake"), TotalOf(stats, U"PixieMesh::generateLOD"));
+	Console << U"run     : {:.1f} ms ({:.3f} ms/frame)"_fmt(runTime, runTime / frames);
+	Console << U"alloc   : {:.1f} /frame ({:.0f} bytes/frame)"_fmt((double)allocCount / frames, (double)allocBytes / frames);
+	Console << U"culled  : {:.1f} meshes/frame"_fmt((double)culled / frames);
+	Console << U"memory  : {} bytes peak"_fmt(PeakMemoryBytes());
+	Console << U"phase (ms/frame)                 frames      min      avg      p99";
+	for (const auto& stat : stats)
+	{
+		const String pad(Max<size_t>(stat.name.size(), 32) - stat.name.size(), U' ');
+		Console << U"{}{} {:>6} {:>8.3f} {:>8.3f} {:>8.3f}"_fmt(stat.name, pad, stat.frames, stat.min, stat.avg, stat.p99);
+	}
+
+	//同じ種なら同じ値になる(決定性の確認用)
+	const PixieMesh& sled = pixieMeshes[ST_SLED];
+	Console << U"state   : progress {:.6f} sled ({:.4f}, {:.4f}, {:.4f}) snow {}"_fmt(scene.progressPos, sled.Pos.x, sled.Pos.y, sled.Pos.z, snowParticles.size());
+
+	if (!tracePath.isEmpty()) PixieProfiler::ExportChromeTrace(tracePath);
+}
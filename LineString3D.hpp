@@ -1,303 +1,618 @@
-﻿//-----------------------------------------------
-//
-//	This file is part of the Siv3D Engine.
-//
-//	Copyright (c) 2008-2019 Ryo Suzuki
-//	Copyright (c) 2016-2019 OpenSiv3D Project
-//
-//	Licensed under the MIT License.
-//
-//-----------------------------------------------
-
-# pragma once
-# include "Siv3D/Fwd.hpp"
-# include "Siv3D/PointVector.hpp"
-# include "Siv3D/Array.hpp"
-# include "Siv3D/Line3D.hpp"
-
-# include "Siv3D/SIMD_Float4.hpp"
-# include "Siv3D/Fwd.hpp"
-
-
-namespace s3d
-{
-	class LineString3D : protected Array<Vec3>
-	{
-	private:
-
-		using base_type = Array<Vec3>;
-
-		[[nodiscard]] LineString3D _catmullRom(int32 interpolation, bool isClosed) const;
-
-//		[[nodiscard]] Polygon _calculateBuffer(double distance, int32 quality, bool isClosed) const;
-
-//		const LineString3D& _paint(Image& dst, int32 thickness, const Color& color, bool isClosed) const;
-
-//		const LineString3D& _overwrite(Image& dst, int32 thickness, const Color& color, bool antialiased, bool isClosed) const;
-
-		const LineString3D& _draw( const ColorF& color, bool isClosed) const;
-
-		void _drawCatmullRom( const ColorF& color, int32 interpolation, bool isClosed) const;
-
-	public:
-
-		using typename base_type::value_type;
-		using typename base_type::pointer;
-		using typename base_type::const_pointer;
-		using typename base_type::reference;
-		using typename base_type::const_reference;
-		using typename base_type::iterator;
-		using typename base_type::const_iterator;
-		using typename base_type::reverse_iterator;
-		using typename base_type::const_reverse_iterator;
-		using typename base_type::size_type;
-		using typename base_type::difference_type;
-		using typename base_type::allocator_type;
-
-		using base_type::Array;
-		using base_type::assign;
-		using base_type::get_allocator;
-		using base_type::at;
-		using base_type::operator[];
-		using base_type::front;
-		using base_type::back;
-		using base_type::data;
-		using base_type::begin;
-		using base_type::cbegin;
-		using base_type::end;
-		using base_type::cend;
-		using base_type::rbegin;
-		using base_type::crbegin;
-		using base_type::rend;
-		using base_type::crend;
-		using base_type::empty;
-		using base_type::size;
-		using base_type::max_size;
-		using base_type::reserve;
-		using base_type::capacity;
-		using base_type::shrink_to_fit;
-		using base_type::clear;
-		using base_type::insert;
-		using base_type::emplace;
-		using base_type::erase;
-		using base_type::push_back;
-		using base_type::emplace_back;
-		using base_type::pop_back;
-		using base_type::resize;
-
-		using base_type::count;
-		using base_type::count_if;
-		using base_type::isEmpty;
-		using base_type::operator bool;
-		using base_type::release;
-		using base_type::size_bytes;
-		using base_type::push_front;
-		using base_type::pop_front;
-		using base_type::choice;
-		using base_type::fill;
-		using base_type::join;
-		using base_type::remove;
-
-		LineString3D() = default;
-
-		LineString3D(const LineString3D& lines);
-
-		LineString3D(LineString3D&& lines);
-		
-		explicit LineString3D(const Array<Vec3>& points);
-
-		explicit LineString3D(Array<Vec3>&& points);
-
-		LineString3D& operator =(const Array<Vec3>& other);
-
-		LineString3D& operator =(Array<Vec3>&& other) noexcept;
-
-		LineString3D& operator =(const LineString3D& other);
-
-		LineString3D& operator =(LineString3D&& other) noexcept;
-
-		void assign(const LineString3D& other);
-
-		void assign(LineString3D&& other) noexcept;
-
-		LineString3D& operator <<(const Vec3& value);
-
-		void swap(LineString3D& other) noexcept;
-
-		LineString3D& append(const Array<Vec3>& other);
-
-		LineString3D& append(const LineString3D& other);
-
-		LineString3D& remove(const Vec3& value);
-
-		LineString3D& remove_at(size_t index);
-
-		template <class Fty>
-		LineString3D& remove_if(Fty f)
-		{
-			base_type::remove_if(f);
-
-			return *this;
-		}
-
-		LineString3D& reverse();
-
-		LineString3D& rotate(std::ptrdiff_t count = 1);
-
-		LineString3D& shuffle();
-
-		template <class URBG>
-		LineString3D& shuffle(URBG&& rbg)
-		{
-			base_type::shuffle(std::forward<URBG>(rbg));
-
-			return *this;
-		}
-
-		[[nodiscard]] LineString3D slice(size_t index) const;
-
-		[[nodiscard]] LineString3D slice(size_t index, size_t length) const;
-
-		[[nodiscard]] size_t num_lines() const noexcept;
-
-		[[nodiscard]] Line3D line3d(size_t index) const;
-
-		[[nodiscard]] LineString3D movedBy(double x, double y, double z) const;
-
-		[[nodiscard]] LineString3D movedBy(const Vec3& v) const;
-
-		LineString3D& moveBy(double x, double y, double z) noexcept;
-
-		LineString3D& moveBy(const Vec3& v) noexcept;
-
-		[[nodiscard]] RectF calculateBoundingRect() const noexcept;
-
-//		template <class Shape2DType>
-//		[[nodiscard]] bool intersects(const Shape2DType& shape) const
-//		{
-//			return Geometry2D::Intersect(*this, shape);
-//		}
-
-		[[nodiscard]] LineString3D densified(double maxDistance) const;
-
-		[[nodiscard]] LineString3D catmullRom(int32 interpolation = 24) const;
-
-		[[nodiscard]] LineString3D catmullRomClosed(int32 interpolation = 24) const;
-
-		[[nodiscard]] Polygon calculateBuffer(double distance, int32 quality = 24) const;
-
-		[[nodiscard]] Polygon calculateBufferClosed(double distance, int32 quality = 24) const;
-
-		const LineString3D& paint(Image& dst, const Color& color) const;
-
-		const LineString3D& paint(Image& dst, int32 thickness, const Color& color) const;
-
-		const LineString3D& paintClosed(Image& dst, const Color& color) const;
-
-		const LineString3D& paintClosed(Image& dst, int32 thickness, const Color& color) const;
-
-		const LineString3D& overwrite(Image& dst, const Color& color, bool antialiased = true) const;
-
-		const LineString3D& overwrite(Image& dst, int32 thickness, const Color& color, bool antialiased = true) const;
-
-		const LineString3D& overwriteClosed(Image& dst, const Color& color, bool antialiased = true) const;
-
-		const LineString3D& overwriteClosed(Image& dst, int32 thickness, const Color& color, bool antialiased = true) const;
-
-		const LineString3D& draw( const ColorF& color = Palette::White) const;
-/*
-		const LineString3D& draw(const Mat4x4 &vp, double thickness, const ColorF& color = Palette::White) const;
-
-		const LineString3D& draw(const Mat4x4 &vp, const LineStyle& style, double thickness, const ColorF& color = Palette::White) const;
-
-		const LineString3D& drawClosed(const Mat4x4 &vp, const ColorF& color = Palette::White) const;
-
-		const LineString3D& drawClosed(const Mat4x4 &vp, double thickness, const ColorF& color = Palette::White) const;
-
-		const LineString3D& drawClosed(const Mat4x4 &vp, const LineStyle& style, double thickness, const ColorF& color = Palette::White) const;
-*/
-
-		void drawCatmullRom(const ColorF& color = Palette::White, int32 interpolation = 24) const;
-/*
-		void drawCatmullRom(const Mat4x4 &vp, double thickness, const ColorF& color = Palette::White, int32 interpolation = 24) const;
-
-		void drawCatmullRom(const Mat4x4 &vp, const LineStyle& style, double thickness = 1.0, const ColorF& color = Palette::White, int32 interpolation = 24) const;
-
-		void drawCatmullRomClosed(const Mat4x4 &vp, const ColorF& color = Palette::White, int32 interpolation = 24) const;
-
-		void drawCatmullRomClosed(const Mat4x4 &vp, double thickness, const ColorF& color = Palette::White, int32 interpolation = 24) const;
-
-		void drawCatmullRomClosed(const Mat4x4 &vp, const LineStyle& style, double thickness = 1.0, const ColorF& color = Palette::White, int32 interpolation = 24) const;
-*/
-		double fullLength = 0;
-		Array<double> lineLength = {0};
-		double updateDistance();
-		Vec3 getCurvedPoint(double progress, size_t start = 0, size_t end = SIZE_MAX);
-	};
-}
-
-//////////////////////////////////////////////////
-//
-//	Format
-//
-//////////////////////////////////////////////////
-
-namespace s3d
-{
-	void Formatter(FormatData& formatData, const LineString3D& value);
-
-	template <class CharType>
-	inline std::basic_ostream<CharType>& operator <<(std::basic_ostream<CharType>& output, const LineString3D& value)
-	{
-		output << CharType('(');
-
-		bool b = false;
-
-		for (const auto& point : value)
-		{
-			if (std::exchange(b, true))
-			{
-				output << CharType(',');
-			}
-
-			output << point;
-		}
-
-		return output << CharType(')');
-	}
-}
-
-//////////////////////////////////////////////////
-//
-//	Hash
-//
-//////////////////////////////////////////////////
-
-namespace std
-{
-	template <>
-	struct hash<s3d::LineString3D>
-	{
-		[[nodiscard]] size_t operator ()(const s3d::LineString3D& value) const noexcept
-		{
-			return s3d::Hash::FNV1a(value.data(), value.size_bytes());
-		}
-	};
-}
-
-//////////////////////////////////////////////////
-//
-//	Swap
-//
-//////////////////////////////////////////////////
-
-namespace std
-{
-	inline void swap(s3d::LineString3D& a, s3d::LineString3D& b) noexcept
-	{
-		a.swap(b);
-	}
-}
-
-
+﻿//-----------------------------------------------
+//
+//	This file is part of the Siv3D Engine.
+//
+//	Copyright (c) 2008-2019 Ryo Suzuki
+//	Copyright (c) 2016-2019 OpenSiv3D Project
+//
+//	Licensed under the MIT License.
+//
+//-----------------------------------------------
+
+# pragma once
+# include "Siv3D/Fwd.hpp"
+# include "Siv3D/PointVector.hpp"
+# include "Siv3D/Array.hpp"
+# include "Siv3D/Line3D.hpp"
+# include "Siv3D/Quaternion.hpp"
+# include "Siv3D/Optional.hpp"
+# include "Siv3D/Ray.hpp"
+# include "Siv3D/Sphere.hpp"
+# include "Siv3D/Box.hpp"
+
+# include "Siv3D/SIMD_Float4.hpp"
+# include "Siv3D/Fwd.hpp"
+
+# include <atomic>
+# include <mutex>
+# include <span>
+
+
+namespace s3d
+{
+	// Catmull-Rom 1区間の3次多項式 p(t) = c0 + c1 t + c2 t^2 + c3 t^3
+	struct CubicSegment3D
+	{
+		Float3 c0, c1, c2, c3;
+
+		[[nodiscard]] Float3 evaluate(const float t) const noexcept
+		{
+			return c0 + t * (c1 + t * (c2 + t * c3));
+		}
+
+		// p'(t) = c1 + 2 c2 t + 3 c3 t^2
+		[[nodiscard]] Float3 derivative(const float t) const noexcept
+		{
+			return c1 + t * (2 * c2 + t * (3 * c3));
+		}
+	};
+
+	// 曲線上の位置と姿勢
+	struct CurveFrame3D
+	{
+		Float3 position;
+
+		Float3 tangent;			// 進行方向(単位)
+
+		Float3 up;				// 回転最小化フレームの上方向(単位)
+
+		Float3 right;			// tangent × up
+
+		Quaternion orientation;	// PixieCamera::getQLookAt と同じ向き(ローカル-Zが進行方向、+Yが上)
+	};
+
+	// 曲線上の最近点
+	struct CurveClosestPoint3D
+	{
+		Float3 position;
+
+		double progress;		// 弧長基準の進行度 [0,1]
+
+		double distance;		// 問い合わせ点からの距離
+	};
+
+	class LineString3D : protected Array<Vec3>
+	{
+	private:
+
+		using base_type = Array<Vec3>;
+
+		[[nodiscard]] LineString3D _catmullRom(int32 interpolation, bool isClosed) const;
+
+//		[[nodiscard]] Polygon _calculateBuffer(double distance, int32 quality, bool isClosed) const;
+
+//		const LineString3D& _paint(Image& dst, int32 thickness, const Color& color, bool isClosed) const;
+
+//		const LineString3D& _overwrite(Image& dst, int32 thickness, const Color& color, bool antialiased, bool isClosed) const;
+
+		const LineString3D& _draw( const ColorF& color, bool isClosed) const;
+
+		void _drawCatmullRom( const ColorF& color, int32 interpolation, double tolerance, bool isClosed) const;
+
+	public:
+
+		using typename base_type::value_type;
+		using typename base_type::pointer;
+		using typename base_type::const_pointer;
+		using typename base_type::reference;
+		using typename base_type::const_reference;
+		using typename base_type::iterator;
+		using typename base_type::const_iterator;
+		using typename base_type::reverse_iterator;
+		using typename base_type::const_reverse_iterator;
+		using typename base_type::size_type;
+		using typename base_type::difference_type;
+		using typename base_type::allocator_type;
+
+		using base_type::Array;
+		using base_type::get_allocator;
+		using base_type::at;
+		using base_type::operator[];
+		using base_type::front;
+		using base_type::back;
+		using base_type::data;
+		using base_type::begin;
+		using base_type::cbegin;
+		using base_type::end;
+		using base_type::cend;
+		using base_type::rbegin;
+		using base_type::crbegin;
+		using base_type::rend;
+		using base_type::crend;
+		using base_type::empty;
+		using base_type::size;
+		using base_type::max_size;
+		using base_type::reserve;
+		using base_type::capacity;
+		using base_type::shrink_to_fit;
+
+		using base_type::count;
+		using base_type::count_if;
+		using base_type::isEmpty;
+		using base_type::operator bool;
+		using base_type::release;
+		using base_type::size_bytes;
+		using base_type::choice;
+		using base_type::join;
+		using base_type::remove;
+
+		// 点列を変更する操作(キャッシュを破棄する)
+
+		template <class... Args>
+		decltype(auto) insert(Args&&... args)
+		{
+			invalidate();
+			return base_type::insert(std::forward<Args>(args)...);
+		}
+
+		template <class... Args>
+		decltype(auto) emplace(Args&&... args)
+		{
+			invalidate();
+			return base_type::emplace(std::forward<Args>(args)...);
+		}
+
+		template <class... Args>
+		decltype(auto) erase(Args&&... args)
+		{
+			invalidate();
+			return base_type::erase(std::forward<Args>(args)...);
+		}
+
+		template <class... Args>
+		decltype(auto) emplace_back(Args&&... args)
+		{
+			invalidate();
+			return base_type::emplace_back(std::forward<Args>(args)...);
+		}
+
+		void push_back(const Vec3& value)
+		{
+			invalidate();
+			base_type::push_back(value);
+		}
+
+		void pop_back()
+		{
+			invalidate();
+			base_type::pop_back();
+		}
+
+		void push_front(const Vec3& value)
+		{
+			invalidate();
+			base_type::push_front(value);
+		}
+
+		void pop_front()
+		{
+			invalidate();
+			base_type::pop_front();
+		}
+
+		void resize(size_t count)
+		{
+			invalidate();
+			base_type::resize(count);
+		}
+
+		void resize(size_t count, const Vec3& value)
+		{
+			invalidate();
+			base_type::resize(count, value);
+		}
+
+		void clear() noexcept
+		{
+			invalidate();
+			base_type::clear();
+		}
+
+		LineString3D& fill(const Vec3& value)
+		{
+			invalidate();
+			base_type::fill(value);
+
+			return *this;
+		}
+
+		void assign(size_t count, const Vec3& value)
+		{
+			invalidate();
+			base_type::assign(count, value);
+		}
+
+		template <class Iterator>
+		void assign(Iterator first, Iterator last)
+		{
+			invalidate();
+			base_type::assign(first, last);
+		}
+
+		void assign(std::initializer_list<Vec3> list)
+		{
+			invalidate();
+			base_type::assign(list);
+		}
+
+		LineString3D() = default;
+
+		LineString3D(const LineString3D& lines);
+
+		LineString3D(LineString3D&& lines);
+		
+		explicit LineString3D(const Array<Vec3>& points);
+
+		explicit LineString3D(Array<Vec3>&& points);
+
+		LineString3D& operator =(const Array<Vec3>& other);
+
+		LineString3D& operator =(Array<Vec3>&& other) noexcept;
+
+		LineString3D& operator =(const LineString3D& other);
+
+		LineString3D& operator =(LineString3D&& other) noexcept;
+
+		void assign(const LineString3D& other);
+
+		void assign(LineString3D&& other) noexcept;
+
+		LineString3D& operator <<(const Vec3& value);
+
+		void swap(LineString3D& other) noexcept;
+
+		LineString3D& append(const Array<Vec3>& other);
+
+		LineString3D& append(const LineString3D& other);
+
+		// 長い経路を逐次伸ばす/縮める。構築済みのキャッシュは端の影響する区間だけ更新する(閉曲線は全体を作り直す)
+		// 弧長の基準は先頭なので、縮めると同じ進行度でも位置が変わる。逐次移動は距離で扱う
+		// 問い合わせ(getPointAtDistance 等)は構築済みのキャッシュをロックせずに読むので、他のスレッドの問い合わせと同時に呼ばない
+		LineString3D& appendPoint(const Vec3& point);
+
+		LineString3D& trimFront(size_t count);
+
+		LineString3D& remove(const Vec3& value);
+
+		LineString3D& remove_at(size_t index);
+
+		template <class Fty>
+		LineString3D& remove_if(Fty f)
+		{
+			invalidate();
+			base_type::remove_if(f);
+
+			return *this;
+		}
+
+		LineString3D& reverse();
+
+		LineString3D& rotate(std::ptrdiff_t count = 1);
+
+		LineString3D& shuffle();
+
+		template <class URBG>
+		LineString3D& shuffle(URBG&& rbg)
+		{
+			invalidate();
+			base_type::shuffle(std::forward<URBG>(rbg));
+
+			return *this;
+		}
+
+		[[nodiscard]] LineString3D slice(size_t index) const;
+
+		[[nodiscard]] LineString3D slice(size_t index, size_t length) const;
+
+		[[nodiscard]] size_t num_lines() const noexcept;
+
+		[[nodiscard]] Line3D line3d(size_t index) const;
+
+		[[nodiscard]] LineString3D movedBy(double x, double y, double z) const;
+
+		[[nodiscard]] LineString3D movedBy(const Vec3& v) const;
+
+		LineString3D& moveBy(double x, double y, double z) noexcept;
+
+		LineString3D& moveBy(const Vec3& v) noexcept;
+
+		[[nodiscard]] RectF calculateBoundingRect() const noexcept;
+
+		// 制御点の3D AABB
+		[[nodiscard]] Box calculateBoundingBox() const noexcept;
+
+		// 全点を行列で変換する(キャッシュを破棄する)。moveBy は平行移動なのでキャッシュを移動して使い続ける
+		LineString3D& transform(const Mat4x4& mat) noexcept;
+
+		[[nodiscard]] LineString3D transformed(const Mat4x4& mat) const;
+
+//		template <class Shape2DType>
+//		[[nodiscard]] bool intersects(const Shape2DType& shape) const
+//		{
+//			return Geometry2D::Intersect(*this, shape);
+//		}
+
+		[[nodiscard]] LineString3D densified(double maxDistance) const;
+
+		[[nodiscard]] LineString3D catmullRom(int32 interpolation = 24) const;
+
+		[[nodiscard]] LineString3D catmullRomClosed(int32 interpolation = 24) const;
+
+		// 弦からのずれが tolerance(ワールド座標)以下になるまで区間毎に二分する。直線に近い区間ほど点が少ない
+		[[nodiscard]] LineString3D catmullRomAdaptive(double tolerance = 0.01) const;
+
+		[[nodiscard]] Polygon calculateBuffer(double distance, int32 quality = 24) const;
+
+		[[nodiscard]] Polygon calculateBufferClosed(double distance, int32 quality = 24) const;
+
+		const LineString3D& paint(Image& dst, const Color& color) const;
+
+		const LineString3D& paint(Image& dst, int32 thickness, const Color& color) const;
+
+		const LineString3D& paintClosed(Image& dst, const Color& color) const;
+
+		const LineString3D& paintClosed(Image& dst, int32 thickness, const Color& color) const;
+
+		const LineString3D& overwrite(Image& dst, const Color& color, bool antialiased = true) const;
+
+		const LineString3D& overwrite(Image& dst, int32 thickness, const Color& color, bool antialiased = true) const;
+
+		const LineString3D& overwriteClosed(Image& dst, const Color& color, bool antialiased = true) const;
+
+		const LineString3D& overwriteClosed(Image& dst, int32 thickness, const Color& color, bool antialiased = true) const;
+
+		const LineString3D& draw( const ColorF& color = Palette::White) const;
+/*
+		const LineString3D& draw(const Mat4x4 &vp, double thickness, const ColorF& color = Palette::White) const;
+
+		const LineString3D& draw(const Mat4x4 &vp, const LineStyle& style, double thickness, const ColorF& color = Palette::White) const;
+
+		const LineString3D& drawClosed(const Mat4x4 &vp, const ColorF& color = Palette::White) const;
+
+		const LineString3D& drawClosed(const Mat4x4 &vp, double thickness, const ColorF& color = Palette::White) const;
+
+		const LineString3D& drawClosed(const Mat4x4 &vp, const LineStyle& style, double thickness, const ColorF& color = Palette::White) const;
+*/
+
+		void drawCatmullRom(const ColorF& color = Palette::White, int32 interpolation = 24) const;
+
+		void drawCatmullRomAdaptive(const ColorF& color = Palette::White, double tolerance = 0.01) const;
+/*
+		void drawCatmullRom(const Mat4x4 &vp, double thickness, const ColorF& color = Palette::White, int32 interpolation = 24) const;
+
+		void drawCatmullRom(const Mat4x4 &vp, const LineStyle& style, double thickness = 1.0, const ColorF& color = Palette::White, int32 interpolation = 24) const;
+
+		void drawCatmullRomClosed(const Mat4x4 &vp, const ColorF& color = Palette::White, int32 interpolation = 24) const;
+
+		void drawCatmullRomClosed(const Mat4x4 &vp, double thickness, const ColorF& color = Palette::White, int32 interpolation = 24) const;
+
+		void drawCatmullRomClosed(const Mat4x4 &vp, const LineStyle& style, double thickness = 1.0, const ColorF& color = Palette::White, int32 interpolation = 24) const;
+*/
+		mutable double fullLength = 0;
+		mutable Array<double> lineLength = {0};
+		double updateDistance();
+		Vec3 getCurvedPoint(double progress, size_t start = 0, size_t end = SIZE_MAX) const;
+
+		// 弧長パラメータでの曲線上の点(等速移動用)。テーブルは初回問い合わせ時に作る
+
+		[[nodiscard]] size_t num_segments() const noexcept;
+
+		// 閉曲線にすると終点→始点の区間が加わり、進行度・距離は一周で巻き戻る(1.2 は 0.2、-0.1 は 0.9)
+		void setClosed(bool closed);
+
+		[[nodiscard]] bool isClosed() const noexcept;
+
+		[[nodiscard]] double getLength() const;
+
+		[[nodiscard]] Vec3 getPointAtDistance(double distance) const;
+
+		[[nodiscard]] Vec3 getPointAtProgress(double progress) const;
+
+		// 進行度の列を一括評価する。区間毎にまとめ、同じ区間の4点ずつをSIMDで評価する
+		// positions.size() は progress.size() 以上。tangents(単位接線)は空なら計算しない
+		void getPointsAtProgress(std::span<const double> progress, std::span<Float3> positions, std::span<Float3> tangents = {}) const;
+
+		// 進行度での単位接線(解析微分)
+		[[nodiscard]] Float3 getTangentAtProgress(double progress) const;
+
+		// 進行度での位置と姿勢。上方向は始点のワールド上方向から平行移動(回転最小化)した向き
+		[[nodiscard]] CurveFrame3D getFrameAt(double progress) const;
+
+		// 空間問い合わせ。弧長サンプル間の線分にBVHを張って探索する(初回問い合わせ時に構築)
+
+		[[nodiscard]] CurveClosestPoint3D closestPoint(const Vec3& pos) const;
+
+		[[nodiscard]] bool intersects(const Sphere& sphere) const;
+
+		// 曲線を半径 radius の管とみなしたレイ判定
+		[[nodiscard]] bool intersects(const Ray& ray, double radius = 0.1) const;
+
+		// 当たった場合はレイ上の距離(管の中心線に最も近づく位置)
+		[[nodiscard]] Optional<float> intersectsAt(const Ray& ray, double radius = 0.1) const;
+
+		// operator[] や data() で点を直接書き換えた後に呼ぶ
+		void invalidate() noexcept;
+
+	private:
+
+		bool m_closed = false;
+
+		// 区間あたりの弧長サンプル数
+		static constexpr size_t ArcSamples = 16;
+
+		// BVHの葉あたりの線分数
+		static constexpr uint32 BVHLeafSize = 4;
+
+		// trimFront で捨てた先頭の区間数。表(m_segments, m_arcLength, m_frameUp)は先頭にこの分を残したまま使い、区間 ss は m_head + ss にある
+		// 捨てた分が生きている区間より多くなったら詰める
+		mutable size_t m_head = 0;
+
+		// 区間毎の多項式係数(セントリペタル) [m_head + num_segments()]
+		mutable Array<CubicSegment3D> m_segments;
+
+		// 累積弧長 [(m_head + num_segments()) * ArcSamples + 1]
+		mutable Array<double> m_arcLength;
+
+		// 弧長サンプル点毎の回転最小化フレームの上方向 [m_arcLength.size()]
+		mutable Array<Float3> m_frameUp;
+
+		// キャッシュの構築は最初の問い合わせで1度だけ(複数スレッドから呼んでよい)
+		// 構築後の問い合わせはロックを取らない。点列を書き換える操作と問い合わせを同時に行わない
+		mutable std::atomic<bool> m_ready{ false };
+
+		mutable std::mutex m_cacheMutex;
+
+		// drawCatmullRom 用の分割済み点列(分割数か許容誤差、開閉が変わるか点列を変更すると作り直す)
+		mutable Array<Float3> m_tessellation;
+
+		mutable int32 m_tessInterpolation = 0;
+
+		mutable double m_tessTolerance = 0;
+
+		mutable bool m_tessClosed = false;
+
+		// 区間毎の m_tessellation 内の開始位置(m_head の分も含む)
+		mutable Array<uint32> m_tessOffset;
+
+		// m_tessellation の有効な先頭(trimFront は先頭区間を次の区間の手前に詰めて置く)
+		mutable size_t m_tessBegin = 0;
+
+		// interpolation == 0 なら tolerance による適応分割
+		// m_cacheMutex を保持し _prepare() 済みで呼ぶ。戻り値はロックを保持している間だけ有効
+		std::span<const Float3> _tessellate(int32 interpolation, double tolerance, bool isClosed) const;
+
+		void _tessellateSegment(const CubicSegment3D& segment, Array<Float3>& out) const;
+
+		void _prepare() const;
+
+		[[nodiscard]] Vec3 _controlPoint(std::ptrdiff_t index) const;
+
+		[[nodiscard]] Vec3 _controlPoint(std::ptrdiff_t index, bool isClosed) const;
+
+		[[nodiscard]] Vec3 _evaluate(size_t segment, double t) const;
+
+		// first 以降の区間/サンプルを作り直す
+		void _updateSegments(size_t first = 0) const;
+
+		// 累積弧長は先頭を基準にした差で使う(先頭を削っても後続を書き換えないため)
+		void _updateArcLength(size_t first = 0) const;
+
+		void _updateFrames(size_t firstSample = 0) const;
+
+		void _invalidateBVH() const noexcept;
+
+		// trimFront で捨てた先頭の区間を表から詰める
+		void _compact() const;
+
+		// 線分BVHの節。子を持つ節は左の子が直後、右の子が start。葉は m_bvhIndex[start, start+count)
+		struct BVHNode
+		{
+			Float3 min, max;
+
+			uint32 start;
+
+			uint32 count;		// 0 なら子を持つ節
+		};
+
+		// 弧長サンプル位置 [m_arcLength.size()]。線分 k はサンプル k→k+1
+		mutable Array<Float3> m_samplePoints;
+
+		mutable Array<BVHNode> m_bvh;
+
+		mutable Array<uint32> m_bvhIndex;
+
+		// 節毎の親(根は UINT32_MAX)と線分毎の葉。端の区間が変わったときに葉から根まで箱を取り直す
+		mutable Array<uint32> m_bvhParent;
+
+		mutable Array<uint32> m_bvhLeaf;
+
+		// 木に入っている線分は [0, m_bvhLines)。それ以降(appendPoint で足した線分)は問い合わせで線形に調べる
+		mutable uint32 m_bvhLines = 0;
+
+		mutable std::atomic<bool> m_bvhReady{ false };
+
+		void _prepareBVH() const;
+
+		uint32 _buildBVH(uint32 begin, uint32 end, const Array<Float3>& centers, uint32 parent) const;
+
+		void _updateSamplePoints(size_t firstSample, size_t endSample) const;
+
+		// [firstLine, endLine) の線分を含む葉と、その親の箱を取り直す
+		void _refitBVH(size_t firstLine, size_t endLine) const;
+
+		// 木の外で線形に調べる最初の線分(捨てた線分は除く)
+		[[nodiscard]] uint32 _firstPendingLine() const noexcept
+		{
+			return (uint32)Max<size_t>(m_bvhLines, m_head * ArcSamples);
+		}
+
+		// 距離 → (区間, 区間内パラメータ)
+		[[nodiscard]] std::pair<size_t, double> _locate(double distance) const;
+	};
+}
+
+//////////////////////////////////////////////////
+//
+//	Format
+//
+//////////////////////////////////////////////////
+
+namespace s3d
+{
+	void Formatter(FormatData& formatData, const LineString3D& value);
+
+	template <class CharType>
+	inline std::basic_ostream<CharType>& operator <<(std::basic_ostream<CharType>& output, const LineString3D& value)
+	{
+		output << CharType('(');
+
+		bool b = false;
+
+		for (const auto& point : value)
+		{
+			if (std::exchange(b, true))
+			{
+				output << CharType(',');
+			}
+
+			output << point;
+		}
+
+		return output << CharType(')');
+	}
+}
+
+//////////////////////////////////////////////////
+//
+//	Hash
+//
+//////////////////////////////////////////////////
+
+namespace std
+{
+	template <>
+	struct hash<s3d::LineString3D>
+	{
+		[[nodiscard]] size_t operator ()(const s3d::LineString3D& value) const noexcept
+		{
+			return s3d::Hash::FNV1a(value.data(), value.size_bytes());
+		}
+	};
+}
+
+//////////////////////////////////////////////////
+//
+//	Swap
+//
+//////////////////////////////////////////////////
+
+namespace std
+{
+	inline void swap(s3d::LineString3D& a, s3d::LineString3D& b) noexcept
+	{
+		a.swap(b);
+	}
+}
+
+
 #include "LineString3D.ipp"
\ No newline at end of file
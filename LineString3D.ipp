@@ -1,440 +1,1548 @@
-﻿//-----------------------------------------------
-//
-//	This file is part of the Siv3D Engine.
-//
-//	Copyright (c) 2008-2019 Ryo Suzuki
-//	Copyright (c) 2016-2019 OpenSiv3D Project
-//
-//	Licensed under the MIT License.
-//
-//-----------------------------------------------
-
-# include "LineString3D.hpp"
-# include <Siv3D/Optional.hpp>
-//# include <Siv3D/Rectangle.hpp>
-# include <Siv3D/Spline.hpp>
-# include <Siv3D/Polygon.hpp>
-//# include <../Siv3D/src/Siv3D/Common/Siv3DEngine.hpp>
-# include <Siv3D/Mat4x4.hpp>
-# include <Siv3D/Graphics2D.hpp>
-#include <Siv3D/EngineLog.hpp>
-
-namespace s3d
-{
-	namespace detail
-	{
-		static constexpr bool Open = false;
-
-		static constexpr bool Closed = true;
-	}
-
-	LineString3D::LineString3D(const LineString3D& lines)
-		: base_type(lines.begin(), lines.end())
-	{
-
-	}
-
-	LineString3D::LineString3D(LineString3D&& lines)
-		: base_type(std::move(lines))
-	{
-
-	}
-
-	LineString3D::LineString3D(const Array<Vec3>& points)
-		: base_type(points.begin(), points.end())
-	{
-
-	}
-
-	LineString3D::LineString3D(Array<Vec3>&& points)
-		: base_type(std::move(points))
-	{
-
-	}
-
-	LineString3D& LineString3D::operator =(const Array<Vec3>& other)
-	{
-		base_type::operator=(other);
-
-		return *this;
-	}
-
-	LineString3D& LineString3D::operator =(Array<Vec3>&& other) noexcept
-	{
-		base_type::operator=(std::move(other));
-
-		return *this;
-	}
-
-	LineString3D& LineString3D::operator =(const LineString3D& other)
-	{
-		base_type::operator=(other);
-
-		return *this;
-	}
-
-	LineString3D& LineString3D::operator =(LineString3D&& other) noexcept
-	{
-		base_type::operator=(std::move(other));
-
-		return *this;
-	}
-
-	void LineString3D::assign(const LineString3D& other)
-	{
-		base_type::operator=(other);
-	}
-
-	void LineString3D::assign(LineString3D&& other) noexcept
-	{
-		base_type::operator=(std::move(other));
-	}
-
-	LineString3D& LineString3D::operator <<(const Vec3& value)
-	{
-		base_type::push_back(value);
-
-		return *this;
-	}
-
-	void LineString3D::swap(LineString3D& other) noexcept
-	{
-		base_type::swap(other);
-	}
-
-	LineString3D& LineString3D::append(const Array<Vec3>& other)
-	{
-		base_type::insert(end(), other.begin(), other.end());
-
-		return *this;
-	}
-
-	LineString3D& LineString3D::append(const LineString3D& other)
-	{
-		base_type::insert(end(), other.begin(), other.end());
-
-		return *this;
-	}
-
-	LineString3D& LineString3D::remove(const Vec3& value)
-	{
-		base_type::remove(value);
-
-		return *this;
-	}
-
-	LineString3D& LineString3D::remove_at(const size_t index)
-	{
-		base_type::remove_at(index);
-
-		return *this;
-	}
-
-	LineString3D& LineString3D::reverse()
-	{
-		base_type::reverse();
-
-		return *this;
-	}
-
-	LineString3D& LineString3D::rotate(const std::ptrdiff_t count)
-	{
-		base_type::rotate(count);
-
-		return *this;
-	}
-
-	LineString3D& LineString3D::shuffle()
-	{
-		base_type::shuffle();
-
-		return *this;
-	}
-
-	LineString3D LineString3D::slice(const size_t index) const
-	{
-		return LineString3D(base_type::slice(index));
-	}
-
-	LineString3D LineString3D::slice(const size_t index, const size_t length) const
-	{
-		return LineString3D(base_type::slice(index, length));
-	}
-
-	size_t LineString3D::num_lines() const noexcept
-	{
-		return size() < 2 ? 0 : size() - 1;
-	}
-
-	Line3D LineString3D::line3d(const size_t index) const
-	{
-		return{ base_type::operator[](index), base_type::operator[](index + 1) };
-	}
-
-	LineString3D LineString3D::movedBy(const double x, const double y, double z) const
-	{
-		return LineString3D(*this).moveBy(x, y, z);
-	}
-
-	LineString3D LineString3D::movedBy(const Vec3& v) const
-	{
-		return movedBy(v.x, v.y, v.z);
-	}
-
-	LineString3D& LineString3D::moveBy(const double x, const double y, const double z) noexcept
-	{
-		for (auto& point : *this)
-		{
-			point.moveBy(x, y, z);
-		}
-
-		return *this;
-	}
-
-	LineString3D& LineString3D::moveBy(const Vec3& v) noexcept
-	{
-		return moveBy(v.x, v.y, v.z);
-	}
-
-	RectF LineString3D::calculateBoundingRect() const noexcept
-	{
-		if (isEmpty())
-		{
-			return RectF(0);
-		}
-
-		const Vec3* it = data();
-		const Vec3* itEnd = it + size();
-
-		double left = it->x;
-		double top = it->y;
-		double right = left;
-		double bottom = top;
-		++it;
-		
-		while (it != itEnd)
-		{
-			if (it->x < left)
-			{
-				left = it->x;
-			}
-			else if (right < it->x)
-			{
-				right = it->x;
-			}
-
-			if (it->y < top)
-			{
-				top = it->y;
-			}
-			else if (bottom < it->y)
-			{
-				bottom = it->y;
-			}
-
-			++it;
-		}
-
-		return RectF(left, top, right - left, bottom - top);
-	}
-
-	LineString3D LineString3D::catmullRom(const int32 interpolation) const
-	{
-		return _catmullRom(interpolation, detail::Open);
-	}
-
-	LineString3D LineString3D::catmullRomClosed(const int32 interpolation) const
-	{
-		return _catmullRom(interpolation, detail::Closed);
-	}
-
-	const LineString3D& LineString3D::draw(const ColorF& color) const
-	{
-		return _draw( color, detail::Open);
-	}
-	void LineString3D::drawCatmullRom( const ColorF& color, const int32 interpolation) const
-	{
-		_drawCatmullRom( color, interpolation, detail::Open);
-	}
-
-
-	enum MODEAXIS { X = 0,Y = 1,Z = 2 };
-
-	float CubicPolynomial(const bool& use_cache,const MODEAXIS& axis,
-							const float &x0, const float &x1,const float &x2,const float &x3,
-							const float &dt0, const float &dt1,const float &dt2,const float &t)
-	{
-		static float c0[3], c1[3], c2[3], c3[3];
-		if (!use_cache)//前回キャッシュと同じ場合は計算をキャンセル
-		{
-			float t0 = ((x1 - x0) / dt0 - (x2 - x0) / (dt0 + dt1) + (x2 - x1) / dt1) * dt1;
-			float t1 = ((x2 - x1) / dt1 - (x3 - x1) / (dt1 + dt2) + (x3 - x2) / dt2) * dt1;
-			c0[axis] = x1;
-			c1[axis] = t0;
-			c2[axis] = -3 * x1 + 3 * x2 - 2 * t0 - t1;
-			c3[axis] = 2 * x1 - 2 * x2 + t0 + t1;
-		}
-		return c0[axis] + c1[axis]*t + c2[axis]*(t*t) + c3[axis]*(t*t*t);
-	}
-
-	Float3 CatmullRom3D(const Float3& p0, 
-						const Float3& p1, 
-						const Float3& p2, 
-						const Float3& p3, 
-						const float& weight)
-	{
-		static Float3 cache[4];
-		static float dt0, dt1, dt2;
-
-		bool use_cache = (cache[0] == p0 && cache[1] == p1 && cache[2] == p2 && cache[3] == p3);
-		if (!use_cache)//前回キャッシュと同じ場合は計算をキャンセル
-		{
-			dt0 = powf( p0.distanceFromSq( p1 ), 0.25f);
-			dt1 = powf( p1.distanceFromSq( p2 ), 0.25f);
-			dt2 = powf( p2.distanceFromSq( p3 ), 0.25f);
-			cache[0] = p0; 
-			cache[1] = p1; 
-			cache[2] = p2; 
-			cache[3] = p3;
-		}
-
-		float x = CubicPolynomial(use_cache, MODEAXIS::X, p0.x, p1.x, p2.x, p3.x, dt0, dt1, dt2, weight);
-		float y = CubicPolynomial(use_cache, MODEAXIS::Y, p0.y, p1.y, p2.y, p3.y, dt0, dt1, dt2, weight);
-		float z = CubicPolynomial(use_cache, MODEAXIS::Z, p0.z, p1.z, p2.z, p3.z, dt0, dt1, dt2, weight);
-		return Float3 { x,y,z };
-	}
-
-
-	LineString3D LineString3D::_catmullRom(const int32 interpolation, const bool isClosed) const
-	{
-		if (size() < 2)
-		{
-			return *this;
-		}
-
-		// [Siv3D ToDo] 最適化
-
-		Array<Vec3> ps;
-		{
-			ps.reserve(size() + 2 + isClosed);
-
-			if (isClosed)
-			{
-				ps.push_back((*this)[size() - 1]);
-			}
-			else
-			{
-//				ps.push_back((*this)[0]);	//始端重複止め
-				ps.push_back((*this)[0]-(*this)[1]+(*this)[0]);	//始端延長
-			}
-
-			for (const auto& point : *this)
-			{
-				ps.push_back(point);
-			}
-
-			if (isClosed)
-			{
-				ps.push_back((*this)[0]);
-				ps.push_back((*this)[1]);
-			}
-			else
-			{
-//				ps.push_back((*this)[size() - 1]);	//終端重複止め
-				ps.push_back((*this)[size() - 2]-(*this)[size() - 1]+(*this)[size() - 1]);	//終端延長
-			}
-		}
-
-		LineString3D splinePoints;
-		{
-			splinePoints.reserve((ps.size() - 3)*interpolation + 1);
-
-			for (size_t i = 1; i < ps.size() - 2; ++i)
-			{
-				const bool isLast = (i + 1) == ps.size() - 2;
-
-				for (int32 t = 0; t < (interpolation + isLast); ++t)
-				{
-//2D
-//					const Vec3 p = Spline::CatmullRom(ps[i - 1], ps[i], ps[i + 1], ps[i + 2], t / static_cast<double>(interpolation));
-
-//3D
-					const Vec3& p0 = ps[i-1];
-					const Vec3& p1 = ps[i+0];
-					const Vec3& p2 = ps[i+1];
-					const Vec3& p3 = ps[i+2];
-			        Vec3 p = CatmullRom3D(p0,p1,p2,p3, t / static_cast<double>(interpolation));
-
-					splinePoints.push_back(p);
-				}
-			}
-		}
-
-		return splinePoints;
-	}
-
-	double LineString3D::updateDistance()
-	{
-		if ( this->num_lines() < 1) assert(1);
-
-		fullLength = 0;
-		for (uint32 i = 0; i < this->num_lines(); i++)
-		{
-			double len = this->at(i).length();
-			lineLength.emplace_back( len );
-			fullLength += len;
-		}
-		return fullLength;
-	}
-
-	Vec3 LineString3D::getCurvedPoint( double progress, size_t start, size_t end )
-	{
-		if ( start > end ) assert(1);
-		if ( end-start < 1 ) assert(1);
-		if ( end == SIZE_MAX) end = this->num_lines() - 1;
-
-		if ( fullLength == 0 )
-			if ( 0 == updateDistance() ) assert(1);
-		double t = (end - start) * progress;
-		size_t ti = (size_t)t;
-		double tw = t - ti;
-
-//		LOG_INFO( U"ti={} tw={:.02f}"_fmt(ti,tw) );
-
-		Vec3 p0;
-		if( ti==0 ) p0 = this->at(ti + 0);
-		else        p0 = this->at(ti - 1);
-		const Vec3& p1 = this->at(ti + 0);
-		const Vec3& p2 = this->at(ti + 1);
-		const Vec3& p3 = this->at(ti + 2);
-		Vec3 p = CatmullRom3D(p0, p1, p2, p3, tw);
-
-		return p;
-	}
-
-	const LineString3D& LineString3D::_draw( const ColorF& color, const bool isClosed) const
-	{
-		if (size() < 2)
-		{
-			return *this;
-		}
-
-		for (uint32 i = 1; i < size(); i += 2)
-		{
-			Line3D(data()[i + 0], data()[i + 1]).draw(color) ;
-		}
-
-		return *this;
-	}
-
-	void LineString3D::_drawCatmullRom( const ColorF& color, const int32 interpolation, const bool isClosed) const
-	{
-		_catmullRom(interpolation, isClosed)._draw( color, isClosed );
-	}
-
-
-	void Formatter( FormatData& formatData, const LineString3D& value )
-	{
-		formatData.string.append(value.join(U", "_sv, U"("_sv, U")"_sv));
-	}
-}
+﻿//-----------------------------------------------
+//
+//	This file is part of the Siv3D Engine.
+//
+//	Copyright (c) 2008-2019 Ryo Suzuki
+//	Copyright (c) 2016-2019 OpenSiv3D Project
+//
+//	Licensed under the MIT License.
+//
+//-----------------------------------------------
+
+# include "LineString3D.hpp"
+# include <Siv3D/Optional.hpp>
+//# include <Siv3D/Rectangle.hpp>
+# include <Siv3D/Spline.hpp>
+# include <Siv3D/Polygon.hpp>
+//# include <../Siv3D/src/Siv3D/Common/Siv3DEngine.hpp>
+# include <Siv3D/Mat4x4.hpp>
+# include <Siv3D/Graphics2D.hpp>
+# include <emmintrin.h>
+#include <Siv3D/EngineLog.hpp>
+# include "PixieProfiler.hpp"
+
+namespace s3d
+{
+	namespace detail
+	{
+		static constexpr bool Open = false;
+
+		static constexpr bool Closed = true;
+	}
+
+	//区間[t0,t1]を、1/4,1/2,3/4点の弦からの距離が tolerance 以下かつ弦長が maxLength 以下になるまで二分する
+	//始点と内部の点を out に追加する(終点は次の区間の始点になるので追加しない)
+	template <class Fty, class PointType>
+	void AdaptiveSubdivide(Fty f, const double t0, const double t1, const Vec3& p0, const Vec3& p1,
+						   const double tolerance, const double maxLength, Array<PointType>& out, const int32 depth = 0)
+	{
+		constexpr int32 MaxDepth = 16;
+
+		const Vec3 chord = p1 - p0;
+		const double chordSq = chord.lengthSq();
+		const auto deviation = [&](const Vec3& p)
+		{
+			const double s = (chordSq > 0) ? Clamp((p - p0).dot(chord) / chordSq, 0.0, 1.0) : 0.0;
+			return p.distanceFrom(p0 + chord * s);
+		};
+
+		const double tm = (t0 + t1) / 2;
+		const Vec3 pm = f(tm);
+
+		bool flat = (depth >= MaxDepth);
+		if (!flat && chordSq <= maxLength * maxLength && deviation(pm) <= tolerance)
+		{
+			flat = (deviation(f((t0 + tm) / 2)) <= tolerance) && (deviation(f((tm + t1) / 2)) <= tolerance);
+		}
+
+		if (flat)
+		{
+			out.push_back(p0);
+			return;
+		}
+
+		AdaptiveSubdivide(f, t0, tm, p0, pm, tolerance, maxLength, out, depth + 1);
+		AdaptiveSubdivide(f, tm, t1, pm, p1, tolerance, maxLength, out, depth + 1);
+	}
+
+	LineString3D::LineString3D(const LineString3D& lines)
+		: base_type(lines.begin(), lines.end())
+		, m_closed(lines.m_closed)
+	{
+
+	}
+
+	LineString3D::LineString3D(LineString3D&& lines)
+		: base_type(std::move(lines))
+		, m_closed(lines.m_closed)
+	{
+		lines.invalidate();
+	}
+
+	LineString3D::LineString3D(const Array<Vec3>& points)
+		: base_type(points.begin(), points.end())
+	{
+
+	}
+
+	LineString3D::LineString3D(Array<Vec3>&& points)
+		: base_type(std::move(points))
+	{
+
+	}
+
+	LineString3D& LineString3D::operator =(const Array<Vec3>& other)
+	{
+		invalidate();
+
+		base_type::operator=(other);
+
+		return *this;
+	}
+
+	LineString3D& LineString3D::operator =(Array<Vec3>&& other) noexcept
+	{
+		invalidate();
+
+		base_type::operator=(std::move(other));
+
+		return *this;
+	}
+
+	LineString3D& LineString3D::operator =(const LineString3D& other)
+	{
+		invalidate();
+
+		base_type::operator=(other);
+		m_closed = other.m_closed;
+
+		return *this;
+	}
+
+	LineString3D& LineString3D::operator =(LineString3D&& other) noexcept
+	{
+		invalidate();
+
+		base_type::operator=(std::move(other));
+		m_closed = other.m_closed;
+		other.invalidate();
+
+		return *this;
+	}
+
+	void LineString3D::assign(const LineString3D& other)
+	{
+		invalidate();
+
+		base_type::operator=(other);
+		m_closed = other.m_closed;
+	}
+
+	void LineString3D::assign(LineString3D&& other) noexcept
+	{
+		invalidate();
+
+		base_type::operator=(std::move(other));
+		m_closed = other.m_closed;
+		other.invalidate();
+	}
+
+	LineString3D& LineString3D::operator <<(const Vec3& value)
+	{
+		invalidate();
+
+		base_type::push_back(value);
+
+		return *this;
+	}
+
+	void LineString3D::swap(LineString3D& other) noexcept
+	{
+		invalidate();
+		other.invalidate();
+
+		base_type::swap(other);
+		std::swap(m_closed, other.m_closed);
+	}
+
+	LineString3D& LineString3D::append(const Array<Vec3>& other)
+	{
+		invalidate();
+
+		base_type::insert(end(), other.begin(), other.end());
+
+		return *this;
+	}
+
+	LineString3D& LineString3D::append(const LineString3D& other)
+	{
+		invalidate();
+
+		base_type::insert(end(), other.begin(), other.end());
+
+		return *this;
+	}
+
+	LineString3D& LineString3D::remove(const Vec3& value)
+	{
+		invalidate();
+
+		base_type::remove(value);
+
+		return *this;
+	}
+
+	LineString3D& LineString3D::remove_at(const size_t index)
+	{
+		invalidate();
+
+		base_type::remove_at(index);
+
+		return *this;
+	}
+
+	LineString3D& LineString3D::reverse()
+	{
+		invalidate();
+
+		base_type::reverse();
+
+		return *this;
+	}
+
+	LineString3D& LineString3D::rotate(const std::ptrdiff_t count)
+	{
+		invalidate();
+
+		base_type::rotate(count);
+
+		return *this;
+	}
+
+	LineString3D& LineString3D::shuffle()
+	{
+		invalidate();
+
+		base_type::shuffle();
+
+		return *this;
+	}
+
+	LineString3D LineString3D::slice(const size_t index) const
+	{
+		return LineString3D(base_type::slice(index));
+	}
+
+	LineString3D LineString3D::slice(const size_t index, const size_t length) const
+	{
+		return LineString3D(base_type::slice(index, length));
+	}
+
+	size_t LineString3D::num_lines() const noexcept
+	{
+		return size() < 2 ? 0 : size() - 1;
+	}
+
+	Line3D LineString3D::line3d(const size_t index) const
+	{
+		return{ base_type::operator[](index), base_type::operator[](index + 1) };
+	}
+
+	LineString3D LineString3D::movedBy(const double x, const double y, double z) const
+	{
+		return LineString3D(*this).moveBy(x, y, z);
+	}
+
+	LineString3D LineString3D::movedBy(const Vec3& v) const
+	{
+		return movedBy(v.x, v.y, v.z);
+	}
+
+	LineString3D& LineString3D::moveBy(const double x, const double y, const double z) noexcept
+	{
+		//点列とキャッシュを揃えて動かす(キャッシュを構築中の問い合わせと競合しないようにロックする)
+		std::lock_guard lock{ m_cacheMutex };
+
+		//点列は x,y,z,x,y,z... と並ぶので、2点(6要素)を3本の2レーンで加算する
+		const __m128d v0 = _mm_setr_pd(x, y);
+		const __m128d v1 = _mm_setr_pd(z, x);
+		const __m128d v2 = _mm_setr_pd(y, z);
+
+		double* p = &data()->x;
+		const size_t n = size();
+		size_t i = 0;
+		for (; i + 2 <= n; i += 2, p += 6)
+		{
+			_mm_storeu_pd(p + 0, _mm_add_pd(_mm_loadu_pd(p + 0), v0));
+			_mm_storeu_pd(p + 2, _mm_add_pd(_mm_loadu_pd(p + 2), v1));
+			_mm_storeu_pd(p + 4, _mm_add_pd(_mm_loadu_pd(p + 4), v2));
+		}
+		if (i < n)
+		{
+			(*this)[i].moveBy(x, y, z);
+		}
+
+		//平行移動では形状が変わらないので、位置を持つキャッシュだけずらす
+		const Float3 d{ x, y, z };
+		for (auto& seg : m_segments) seg.c0 += d;
+		for (auto& pt : m_tessellation) pt += d;
+		for (auto& pt : m_samplePoints) pt += d;
+		for (auto& node : m_bvh)
+		{
+			node.min += d;
+			node.max += d;
+		}
+
+		return *this;
+	}
+
+	LineString3D& LineString3D::moveBy(const Vec3& v) noexcept
+	{
+		return moveBy(v.x, v.y, v.z);
+	}
+
+	LineString3D& LineString3D::transform(const Mat4x4& mat) noexcept
+	{
+		invalidate();
+
+		//点を float に落とすと原点から遠い座標の精度が失われるので、行列の要素を double にして double のまま変換する
+		//1点を x,y と z,w の2本の2レーンで計算する(Mat4x4::transformPoint と同じく w で割る。w が 0 の点は割らない)
+		DirectX::XMFLOAT4X4 m;
+		DirectX::XMStoreFloat4x4(&m, mat.value);
+		const __m128d r0xy = _mm_setr_pd(m._11, m._12), r0zw = _mm_setr_pd(m._13, m._14);
+		const __m128d r1xy = _mm_setr_pd(m._21, m._22), r1zw = _mm_setr_pd(m._23, m._24);
+		const __m128d r2xy = _mm_setr_pd(m._31, m._32), r2zw = _mm_setr_pd(m._33, m._34);
+		const __m128d r3xy = _mm_setr_pd(m._41, m._42), r3zw = _mm_setr_pd(m._43, m._44);
+		const bool affine = (m._14 == 0 && m._24 == 0 && m._34 == 0 && m._44 == 1);
+
+		double* p = &data()->x;
+		const size_t n = size();
+		for (size_t i = 0; i < n; i++, p += 3)
+		{
+			const __m128d x = _mm_set1_pd(p[0]), y = _mm_set1_pd(p[1]), z = _mm_set1_pd(p[2]);
+			__m128d xy = _mm_add_pd(_mm_add_pd(_mm_mul_pd(x, r0xy), _mm_mul_pd(y, r1xy)), _mm_add_pd(_mm_mul_pd(z, r2xy), r3xy));
+			__m128d zw = _mm_add_pd(_mm_add_pd(_mm_mul_pd(x, r0zw), _mm_mul_pd(y, r1zw)), _mm_add_pd(_mm_mul_pd(z, r2zw), r3zw));
+			if (!affine)
+			{
+				const __m128d w = _mm_unpackhi_pd(zw, zw);
+				if (_mm_cvtsd_f64(w) != 0)
+				{
+					xy = _mm_div_pd(xy, w);
+					zw = _mm_div_sd(zw, w);
+				}
+			}
+			_mm_storeu_pd(p, xy);
+			_mm_store_sd(p + 2, zw);
+		}
+
+		return *this;
+	}
+
+	LineString3D LineString3D::transformed(const Mat4x4& mat) const
+	{
+		return LineString3D(*this).transform(mat);
+	}
+
+	RectF LineString3D::calculateBoundingRect() const noexcept
+	{
+		if (isEmpty())
+		{
+			return RectF(0);
+		}
+
+		const Box box = calculateBoundingBox();
+		const Vec3 vmin = box.center - box.size / 2;
+
+		return RectF(vmin.x, vmin.y, box.size.x, box.size.y);
+	}
+
+	Box LineString3D::calculateBoundingBox() const noexcept
+	{
+		if (isEmpty())
+		{
+			return Box{ Vec3{ 0,0,0 }, Vec3{ 0,0,0 } };
+		}
+
+		//moveBy と同じく2点(6要素)を3本の2レーンで比較する
+		const double* p = &data()->x;
+		const size_t n = size();
+		__m128d min0 = _mm_setr_pd(p[0], p[1]), max0 = min0;
+		__m128d min1 = _mm_setr_pd(p[2], p[0]), max1 = min1;
+		__m128d min2 = _mm_setr_pd(p[1], p[2]), max2 = min2;
+
+		size_t i = 0;
+		for (; i + 2 <= n; i += 2, p += 6)
+		{
+			const __m128d a = _mm_loadu_pd(p + 0), b = _mm_loadu_pd(p + 2), c = _mm_loadu_pd(p + 4);
+			min0 = _mm_min_pd(min0, a); max0 = _mm_max_pd(max0, a);
+			min1 = _mm_min_pd(min1, b); max1 = _mm_max_pd(max1, b);
+			min2 = _mm_min_pd(min2, c); max2 = _mm_max_pd(max2, c);
+		}
+
+		double lo0[2], lo1[2], lo2[2], hi0[2], hi1[2], hi2[2];
+		_mm_storeu_pd(lo0, min0); _mm_storeu_pd(lo1, min1); _mm_storeu_pd(lo2, min2);
+		_mm_storeu_pd(hi0, max0); _mm_storeu_pd(hi1, max1); _mm_storeu_pd(hi2, max2);
+
+		Vec3 vmin{ Min(lo0[0], lo1[1]), Min(lo0[1], lo2[0]), Min(lo1[0], lo2[1]) };
+		Vec3 vmax{ Max(hi0[0], hi1[1]), Max(hi0[1], hi2[0]), Max(hi1[0], hi2[1]) };
+		if (i < n)
+		{
+			const Vec3& last = (*this)[i];
+			vmin = Vec3{ Min(vmin.x, last.x), Min(vmin.y, last.y), Min(vmin.z, last.z) };
+			vmax = Vec3{ Max(vmax.x, last.x), Max(vmax.y, last.y), Max(vmax.z, last.z) };
+		}
+
+		return Box((vmin + vmax) / 2, vmax - vmin);
+	}
+
+	LineString3D LineString3D::catmullRom(const int32 interpolation) const
+	{
+		return _catmullRom(interpolation, detail::Open);
+	}
+
+	LineString3D LineString3D::catmullRomClosed(const int32 interpolation) const
+	{
+		return _catmullRom(interpolation, detail::Closed);
+	}
+
+	LineString3D LineString3D::catmullRomAdaptive(const double tolerance) const
+	{
+		if (size() < 2)
+		{
+			return *this;
+		}
+
+		_prepare();
+
+		Array<Vec3> splinePoints;
+		for (size_t ss = m_head; ss < m_segments.size(); ss++)
+		{
+			const CubicSegment3D& seg = m_segments[ss];
+			const auto f = [&](double t) { return Vec3{ seg.evaluate((float)t) }; };
+			AdaptiveSubdivide(f, 0.0, 1.0, f(0.0), f(1.0), tolerance, Math::Inf, splinePoints);
+		}
+		splinePoints.push_back(m_closed ? front() : back());
+
+		return LineString3D{ std::move(splinePoints) };
+	}
+
+	LineString3D LineString3D::densified(const double maxDistance) const
+	{
+		if (size() < 2 || maxDistance <= 0)
+		{
+			return *this;
+		}
+
+		//直線は常に平坦なので、弦長の条件だけで二分される
+		Array<Vec3> points;
+		for (size_t i = 0; i + 1 < size(); ++i)
+		{
+			const Vec3& p0 = (*this)[i];
+			const Vec3& p1 = (*this)[i + 1];
+			const auto f = [&](double t) { return p0.lerp(p1, t); };
+			AdaptiveSubdivide(f, 0.0, 1.0, p0, p1, Math::Inf, maxDistance, points);
+		}
+		points.push_back(back());
+
+		return LineString3D{ std::move(points) };
+	}
+
+	const LineString3D& LineString3D::draw(const ColorF& color) const
+	{
+		return _draw( color, detail::Open);
+	}
+	void LineString3D::drawCatmullRom( const ColorF& color, const int32 interpolation) const
+	{
+		_drawCatmullRom( color, interpolation, 0.0, detail::Open);
+	}
+
+	void LineString3D::drawCatmullRomAdaptive(const ColorF& color, const double tolerance) const
+	{
+		_drawCatmullRom(color, 0, tolerance, detail::Open);
+	}
+
+
+	CubicSegment3D CatmullRomSegment(const Float3& p0,
+									 const Float3& p1,
+									 const Float3& p2,
+									 const Float3& p3)
+	{
+		//セントリペタル(α=0.5)のノット間隔。重複点での0除算を避ける
+		const float dt0 = Max(powf(p0.distanceFromSq(p1), 0.25f), 1e-4f);
+		const float dt1 = Max(powf(p1.distanceFromSq(p2), 0.25f), 1e-4f);
+		const float dt2 = Max(powf(p2.distanceFromSq(p3), 0.25f), 1e-4f);
+
+		const Float3 t0 = ((p1 - p0) / dt0 - (p2 - p0) / (dt0 + dt1) + (p2 - p1) / dt1) * dt1;
+		const Float3 t1 = ((p2 - p1) / dt1 - (p3 - p1) / (dt1 + dt2) + (p3 - p2) / dt2) * dt1;
+
+		CubicSegment3D seg;
+		seg.c0 = p1;
+		seg.c1 = t0;
+		seg.c2 = -3 * p1 + 3 * p2 - 2 * t0 - t1;
+		seg.c3 = 2 * p1 - 2 * p2 + t0 + t1;
+		return seg;
+	}
+
+	Float3 CatmullRom3D(const Float3& p0,
+						const Float3& p1,
+						const Float3& p2,
+						const Float3& p3,
+						const float& weight)
+	{
+		return CatmullRomSegment(p0, p1, p2, p3).evaluate(weight);
+	}
+
+
+	LineString3D LineString3D::_catmullRom(const int32 interpolation, const bool isClosed) const
+	{
+		if (size() < 2 || interpolation < 1)
+		{
+			return *this;
+		}
+
+		//drawCatmullRom や距離の問い合わせと同じ区間(_controlPoint の端点処理)で標本化する
+		const bool closed = m_closed || isClosed;
+		const size_t nseg = closed ? size() : size() - 1;
+
+		LineString3D splinePoints;
+		splinePoints.reserve(nseg * interpolation + 1);
+
+		for (size_t ss = 0; ss < nseg; ++ss)
+		{
+			const std::ptrdiff_t i = ss;
+			const CubicSegment3D seg = CatmullRomSegment(_controlPoint(i - 1, closed), _controlPoint(i, closed), _controlPoint(i + 1, closed), _controlPoint(i + 2, closed));
+
+			for (int32 t = 0; t < interpolation; ++t)
+			{
+				splinePoints.push_back(Vec3{ seg.evaluate(t / static_cast<float>(interpolation)) });
+			}
+		}
+		splinePoints.push_back(closed ? front() : back());
+
+		return splinePoints;
+	}
+
+	double LineString3D::updateDistance()
+	{
+		if ( this->num_lines() < 1) assert(1);
+
+		_prepare();
+		return fullLength;
+	}
+
+	Vec3 LineString3D::getCurvedPoint( double progress, size_t start, size_t end ) const
+	{
+		if (size() < 2) return isEmpty() ? Vec3{ 0,0,0 } : front();
+
+		_prepare();
+
+		const size_t nseg = m_segments.size() - m_head;
+
+		//閉曲線は全区間を一周として扱い、進行度は[0,1)に巻き戻す
+		if (m_closed && start == 0 && end == SIZE_MAX)
+		{
+			const double t = nseg * (progress - std::floor(progress));
+			const size_t ti = Min((size_t)t, nseg - 1);
+			return m_segments[m_head + ti].evaluate((float)(t - ti));
+		}
+
+		const size_t last = nseg - 1;
+		if ( end == SIZE_MAX) end = this->num_lines() - 1;
+		start = Min(start, last);
+		end = Clamp(end, start, last);
+
+		double t = (end - start) * Clamp(progress, 0.0, 1.0);
+		size_t ti = Min((size_t)t, end - start);
+		double tw = t - ti;
+
+		return m_segments[m_head + start + ti].evaluate((float)tw);
+	}
+
+	void LineString3D::invalidate() noexcept
+	{
+		m_ready.store(false, std::memory_order_release);
+		m_head = 0;
+		m_segments.clear();
+		m_arcLength.clear();
+		m_frameUp.clear();
+		m_tessellation.clear();
+		m_tessInterpolation = 0;
+		m_tessOffset.clear();
+		m_tessBegin = 0;
+		_invalidateBVH();
+		fullLength = 0;
+	}
+
+	void LineString3D::_prepare() const
+	{
+		if (m_ready.load(std::memory_order_acquire)) return;
+
+		std::lock_guard lock{ m_cacheMutex };
+		if (m_ready.load(std::memory_order_relaxed)) return;
+
+		PIXIE_PROFILE("LineString3D::prepare");
+		_updateSegments();
+		_updateArcLength();
+		_updateFrames();
+		m_ready.store(true, std::memory_order_release);
+	}
+
+	size_t LineString3D::num_segments() const noexcept
+	{
+		if (size() < 2) return 0;
+		return m_closed ? size() : size() - 1;
+	}
+
+	void LineString3D::setClosed(const bool closed)
+	{
+		if (m_closed == closed) return;
+
+		invalidate();
+		m_closed = closed;
+	}
+
+	bool LineString3D::isClosed() const noexcept
+	{
+		return m_closed;
+	}
+
+	Vec3 LineString3D::_controlPoint(const std::ptrdiff_t index) const
+	{
+		return _controlPoint(index, m_closed);
+	}
+
+	Vec3 LineString3D::_controlPoint(const std::ptrdiff_t index, const bool isClosed) const
+	{
+		const std::ptrdiff_t n = size();
+
+		//閉曲線は前後の点を巡回させる
+		if (isClosed) return (*this)[((index % n) + n) % n];
+
+		if (index < 0) return (*this)[0] * 2 - (*this)[1];					//始端延長
+		if (n <= index) return (*this)[n - 1] * 2 - (*this)[n - 2];		//終端延長
+		return (*this)[index];
+	}
+
+	Vec3 LineString3D::_evaluate(const size_t segment, const double t) const
+	{
+		return m_segments[segment].evaluate((float)t);
+	}
+
+	void LineString3D::_updateSegments(const size_t first) const
+	{
+		const size_t nseg = num_segments();
+		m_segments.resize(m_head + nseg);
+
+		for (size_t ss = first; ss < nseg; ss++)
+		{
+			const std::ptrdiff_t i = ss;
+			m_segments[m_head + ss] = CatmullRomSegment(_controlPoint(i - 1), _controlPoint(i), _controlPoint(i + 1), _controlPoint(i + 2));
+		}
+	}
+
+	void LineString3D::_updateArcLength(const size_t first) const
+	{
+		const size_t nseg = num_segments();
+		const size_t head = m_head;
+
+		m_arcLength.resize((head + nseg) * ArcSamples + 1);
+		lineLength.resize(nseg);
+
+		double total = m_arcLength[(head + first) * ArcSamples];
+		for (size_t ss = first; ss < nseg; ss++)
+		{
+			const double begin = total;
+			Vec3 prev = (*this)[ss];
+			for (size_t kk = 1; kk <= ArcSamples; kk++)
+			{
+				const Vec3 p = (kk == ArcSamples) ? (*this)[(ss + 1) % size()] : _evaluate(head + ss, kk / static_cast<double>(ArcSamples));
+				total += prev.distanceFrom(p);
+				m_arcLength[(head + ss) * ArcSamples + kk] = total;
+				prev = p;
+			}
+			lineLength[ss] = total - begin;
+		}
+		fullLength = total - m_arcLength[head * ArcSamples];
+	}
+
+	void LineString3D::_updateFrames(const size_t firstSample) const
+	{
+		const size_t nseg = num_segments();
+		const size_t nsample = nseg * ArcSamples + 1;
+		const size_t head = m_head;
+		const size_t hs = head * ArcSamples;
+		m_frameUp.resize(hs + nsample);
+		if (nseg == 0) return;
+
+		const auto samplePoint = [&](size_t kk) { return (kk == nsample - 1) ? std::pair{ head + nseg - 1, 1.0f } : std::pair{ head + kk / ArcSamples, (kk % ArcSamples) / float(ArcSamples) }; };
+		const auto unitTangent = [&](size_t kk)
+		{
+			const auto [ss, t] = samplePoint(kk);
+			const Float3 d = m_segments[ss].derivative(t);
+			return (d.lengthSq() > 0) ? d.normalized() : Float3{ 0,0,1 };
+		};
+
+		//始点の上方向はワールド上方向を接線に直交化したもの。途中からなら直前のサンプルを引き継ぐ
+		Float3 t0 = unitTangent(firstSample);
+		Float3 up = m_frameUp[hs + firstSample];
+		if (firstSample == 0)
+		{
+			up = Float3{ 0,1,0 };
+			if (Abs(t0.dot(up)) > 0.999f) up = Float3{ 1,0,0 };
+			up = (up - t0 * t0.dot(up)).normalized();
+			m_frameUp[hs] = up;
+		}
+
+		//二重反射法(Wang et al. 2008)で順に平行移動する
+		const auto [s0, w0] = samplePoint(firstSample);
+		Float3 x0 = m_segments[s0].evaluate(w0);
+		for (size_t kk = firstSample + 1; kk < nsample; kk++)
+		{
+			const auto [ss, t] = samplePoint(kk);
+			const Float3 x1 = m_segments[ss].evaluate(t);
+			const Float3 t1 = unitTangent(kk);
+
+			const Float3 v1 = x1 - x0;
+			const float c1 = v1.dot(v1);
+			Float3 rL = up, tL = t0;
+			if (c1 > 1e-12f)
+			{
+				rL = up - v1 * (2 / c1 * v1.dot(up));
+				tL = t0 - v1 * (2 / c1 * v1.dot(t0));
+			}
+			const Float3 v2 = t1 - tL;
+			const float c2 = v2.dot(v2);
+			up = (c2 > 1e-12f) ? rL - v2 * (2 / c2 * v2.dot(rL)) : rL;
+
+			up = (up - t1 * t1.dot(up)).normalized();
+			m_frameUp[hs + kk] = up;
+			x0 = x1;
+			t0 = t1;
+		}
+
+		//閉曲線は一周したときの上方向のねじれを弧長に比例して分配し、継ぎ目で一致させる
+		if (m_closed && firstSample == 0 && fullLength > 0)
+		{
+			const Float3 ts = unitTangent(0);
+			const Float3 ue = m_frameUp[hs + nsample - 1];
+			const float twist = std::atan2(ue.cross(m_frameUp[hs]).dot(ts), ue.dot(m_frameUp[hs]));
+
+			for (size_t kk = 1; kk < nsample; kk++)
+			{
+				const float angle = twist * (float)((m_arcLength[hs + kk] - m_arcLength[hs]) / fullLength);
+				const Float3 tk = unitTangent(kk);
+				const Float3 uk = m_frameUp[hs + kk];
+				m_frameUp[hs + kk] = (uk * std::cos(angle) + tk.cross(uk) * std::sin(angle)).normalized();
+			}
+		}
+	}
+
+	void LineString3D::_invalidateBVH() const noexcept
+	{
+		m_bvhReady.store(false, std::memory_order_release);
+		m_samplePoints.clear();
+		m_bvh.clear();
+		m_bvhIndex.clear();
+		m_bvhParent.clear();
+		m_bvhLeaf.clear();
+		m_bvhLines = 0;
+	}
+
+	void LineString3D::_compact() const
+	{
+		const size_t hs = m_head * ArcSamples;
+		m_segments.erase(m_segments.begin(), m_segments.begin() + m_head);
+		m_arcLength.erase(m_arcLength.begin(), m_arcLength.begin() + hs);
+		m_frameUp.erase(m_frameUp.begin(), m_frameUp.begin() + hs);
+		m_head = 0;
+
+		//添字が変わるので分割点列とBVHは次の描画/問い合わせで作り直す
+		m_tessellation.clear();
+		m_tessOffset.clear();
+		m_tessBegin = 0;
+		_invalidateBVH();
+	}
+
+	LineString3D& LineString3D::appendPoint(const Vec3& point)
+	{
+		//キャッシュ未構築や閉曲線は通常の追加(次の問い合わせで全体を作る)
+		if (m_closed || size() < 3 || !m_ready.load(std::memory_order_acquire))
+		{
+			push_back(point);
+			return *this;
+		}
+
+		std::lock_guard lock{ m_cacheMutex };
+		base_type::push_back(point);
+
+		//旧終端区間は終端延長の制御点が実点に変わる。それより前の区間は変わらない
+		const size_t first = size() - 3;
+		_updateSegments(first);
+		_updateArcLength(first);
+		_updateFrames(first * ArcSamples);
+
+		//BVHは旧終端区間の葉だけ更新し、新しい区間の線分は木の外に置いて線形に調べる。外の線分が増えたら作り直す
+		if (m_bvhReady.load(std::memory_order_relaxed))
+		{
+			const size_t firstSample = (m_head + first) * ArcSamples;
+			m_samplePoints.resize(m_arcLength.size());
+			_updateSamplePoints(firstSample, m_samplePoints.size());
+			_refitBVH(firstSample, firstSample + ArcSamples);
+
+			const size_t pending = (m_samplePoints.size() - 1) - m_bvhLines;
+			if (pending * 4 > num_segments() * ArcSamples) _invalidateBVH();
+		}
+
+		if (m_tessellation && !m_tessClosed)
+		{
+			const size_t pf = m_head + first;
+			m_tessellation.resize(m_tessOffset[pf]);
+			m_tessOffset.resize(pf);
+			for (size_t ss = pf; ss < m_segments.size(); ss++)
+			{
+				m_tessOffset.push_back((uint32)m_tessellation.size());
+				_tessellateSegment(m_segments[ss], m_tessellation);
+			}
+			m_tessellation.push_back(back());
+		}
+		else
+		{
+			m_tessellation.clear();
+		}
+
+		return *this;
+	}
+
+	LineString3D& LineString3D::trimFront(size_t count)
+	{
+		count = Min(count, size());
+		if (count == 0) return *this;
+
+		if (m_closed || size() - count < 3 || !m_ready.load(std::memory_order_acquire))
+		{
+			erase(begin(), begin() + count);
+			return *this;
+		}
+
+		std::lock_guard lock{ m_cacheMutex };
+
+		//点列と lineLength は公開の配列で先頭から添字を振るので詰める。内部の表は先頭を捨てたことにして m_head だけ進める
+		base_type::erase(base_type::begin(), base_type::begin() + count);
+		lineLength.erase(lineLength.begin(), lineLength.begin() + count);
+		m_head += count;
+
+		//新しい先頭区間は始端延長の制御点が変わる。2番目以降の区間は変わらない
+		const size_t h = m_head;
+		const size_t hs = h * ArcSamples;
+		m_segments[h] = CatmullRomSegment(_controlPoint(-1), _controlPoint(0), _controlPoint(1), _controlPoint(2));
+
+		//先頭区間の終端の累積弧長を保ったまま、区間内を後ろから引き直す
+		Vec3 next = (*this)[1];
+		for (size_t kk = ArcSamples; kk-- > 0; )
+		{
+			const Vec3 p = (kk == 0) ? (*this)[0] : _evaluate(h, kk / static_cast<double>(ArcSamples));
+			m_arcLength[hs + kk] = m_arcLength[hs + kk + 1] - p.distanceFrom(next);
+			next = p;
+
+			//上方向は新しい接線に直交化し直す
+			const Float3 d = m_segments[h].derivative(kk / static_cast<float>(ArcSamples));
+			if (d.lengthSq() > 0)
+			{
+				const Float3 tk = d.normalized();
+				const Float3 up = m_frameUp[hs + kk] - tk * tk.dot(m_frameUp[hs + kk]);
+				if (up.lengthSq() > 0) m_frameUp[hs + kk] = up.normalized();
+			}
+		}
+		lineLength[0] = m_arcLength[hs + ArcSamples] - m_arcLength[hs];
+		fullLength = m_arcLength.back() - m_arcLength[hs];
+
+		//BVHは捨てた線分と先頭区間の葉だけ箱を縮め直す
+		if (m_bvhReady.load(std::memory_order_relaxed))
+		{
+			_updateSamplePoints(hs, hs + ArcSamples + 1);
+			_refitBVH(hs - count * ArcSamples, hs + ArcSamples);
+		}
+
+		//分割点列は先頭区間だけ引き直し、次の区間の手前に詰めて置く(入らなければ作り直す)
+		if (m_tessellation && !m_tessClosed && h + 1 < m_tessOffset.size())
+		{
+			Array<Float3> head;
+			_tessellateSegment(m_segments[h], head);
+
+			const uint32 cut = m_tessOffset[h + 1];
+			if (head.size() <= cut)
+			{
+				const uint32 start = cut - (uint32)head.size();
+				std::copy(head.begin(), head.end(), m_tessellation.begin() + start);
+				m_tessOffset[h] = start;
+				m_tessBegin = start;
+			}
+			else
+			{
+				m_tessellation.clear();
+			}
+		}
+		else
+		{
+			m_tessellation.clear();
+		}
+
+		//捨てた区間が生きている区間より多くなったら表を詰める(1区間あたり償却 O(1))
+		if (m_head > num_segments()) _compact();
+
+		return *this;
+	}
+
+	void LineString3D::_prepareBVH() const
+	{
+		_prepare();
+		if (m_bvhReady.load(std::memory_order_acquire)) return;
+
+		std::lock_guard lock{ m_cacheMutex };
+		if (m_bvhReady.load(std::memory_order_relaxed)) return;
+
+		const size_t hs = m_head * ArcSamples;
+		const size_t nsample = m_arcLength.size();
+		m_samplePoints.resize(nsample);
+		_updateSamplePoints(hs, nsample);
+
+		//捨てた先頭の線分は木に入れない
+		const uint32 nline = (uint32)(nsample - 1);
+		const uint32 nlive = nline - (uint32)hs;
+		Array<Float3> centers(nline);
+		m_bvhIndex.resize(nlive);
+		for (uint32 ii = 0; ii < nlive; ii++)
+		{
+			const uint32 kk = (uint32)hs + ii;
+			m_bvhIndex[ii] = kk;
+			centers[kk] = (m_samplePoints[kk] + m_samplePoints[kk + 1]) / 2;
+		}
+
+		m_bvh.clear();
+		m_bvh.reserve(2 * (nlive / BVHLeafSize + 1));
+		m_bvhParent.clear();
+		m_bvhParent.reserve(m_bvh.capacity());
+		m_bvhLeaf.resize(nline);
+		_buildBVH(0, nlive, centers, UINT32_MAX);
+		m_bvhLines = nline;
+
+		m_bvhReady.store(true, std::memory_order_release);
+	}
+
+	void LineString3D::_updateSamplePoints(const size_t firstSample, const size_t endSample) const
+	{
+		const size_t nseg = m_segments.size();
+		for (size_t kk = firstSample; kk < endSample; kk++)
+		{
+			const size_t ss = Min(kk / ArcSamples, nseg - 1);
+			const float t = (kk - ss * ArcSamples) / static_cast<float>(ArcSamples);
+			m_samplePoints[kk] = m_segments[ss].evaluate(t);
+		}
+	}
+
+	void LineString3D::_refitBVH(const size_t firstLine, const size_t endLine) const
+	{
+		const size_t hs = m_head * ArcSamples;
+		uint32 prevLeaf = UINT32_MAX;
+		for (size_t kk = firstLine; kk < Min<size_t>(endLine, m_bvhLines); kk++)
+		{
+			const uint32 leaf = m_bvhLeaf[kk];
+			if (leaf == prevLeaf) continue;
+			prevLeaf = leaf;
+
+			//葉の箱は生きている線分だけで取り直す(全て捨てたなら空の箱)
+			BVHNode& node = m_bvh[leaf];
+			Float3 vmin{ FLT_MAX, FLT_MAX, FLT_MAX }, vmax{ -FLT_MAX, -FLT_MAX, -FLT_MAX };
+			for (uint32 ii = node.start; ii < node.start + node.count; ii++)
+			{
+				const uint32 line = m_bvhIndex[ii];
+				if (line < hs) continue;
+				for (const Float3& p : { m_samplePoints[line], m_samplePoints[line + 1] })
+				{
+					vmin = Float3{ Min(vmin.x, p.x), Min(vmin.y, p.y), Min(vmin.z, p.z) };
+					vmax = Float3{ Max(vmax.x, p.x), Max(vmax.y, p.y), Max(vmax.z, p.z) };
+				}
+			}
+			node.min = vmin;
+			node.max = vmax;
+
+			//親を根まで取り直す
+			for (uint32 index = m_bvhParent[leaf]; index != UINT32_MAX; index = m_bvhParent[index])
+			{
+				const BVHNode& left = m_bvh[index + 1];
+				const BVHNode& right = m_bvh[m_bvh[index].start];
+				m_bvh[index].min = Float3{ Min(left.min.x, right.min.x), Min(left.min.y, right.min.y), Min(left.min.z, right.min.z) };
+				m_bvh[index].max = Float3{ Max(left.max.x, right.max.x), Max(left.max.y, right.max.y), Max(left.max.z, right.max.z) };
+			}
+		}
+	}
+
+	uint32 LineString3D::_buildBVH(const uint32 begin, const uint32 end, const Array<Float3>& centers, const uint32 parent) const
+	{
+		const uint32 index = (uint32)m_bvh.size();
+		m_bvh.emplace_back();
+		m_bvhParent.push_back(parent);
+
+		Float3 vmin{ FLT_MAX, FLT_MAX, FLT_MAX }, vmax{ -FLT_MAX, -FLT_MAX, -FLT_MAX };
+		Float3 cmin = vmin, cmax = vmax;
+		for (uint32 ii = begin; ii < end; ii++)
+		{
+			const uint32 kk = m_bvhIndex[ii];
+			for (const Float3& p : { m_samplePoints[kk], m_samplePoints[kk + 1] })
+			{
+				vmin = Float3{ Min(vmin.x, p.x), Min(vmin.y, p.y), Min(vmin.z, p.z) };
+				vmax = Float3{ Max(vmax.x, p.x), Max(vmax.y, p.y), Max(vmax.z, p.z) };
+			}
+			const Float3& c = centers[kk];
+			cmin = Float3{ Min(cmin.x, c.x), Min(cmin.y, c.y), Min(cmin.z, c.z) };
+			cmax = Float3{ Max(cmax.x, c.x), Max(cmax.y, c.y), Max(cmax.z, c.z) };
+		}
+
+		if (end - begin <= BVHLeafSize)
+		{
+			m_bvh[index] = BVHNode{ vmin, vmax, begin, end - begin };
+			for (uint32 ii = begin; ii < end; ii++) m_bvhLeaf[m_bvhIndex[ii]] = index;
+			return index;
+		}
+
+		//中心の広がりが最大の軸で中央値分割
+		const Float3 extent = cmax - cmin;
+		const int32 axis = (extent.x >= extent.y && extent.x >= extent.z) ? 0 : (extent.y >= extent.z) ? 1 : 2;
+		const uint32 mid = (begin + end) / 2;
+		std::nth_element(m_bvhIndex.begin() + begin, m_bvhIndex.begin() + mid, m_bvhIndex.begin() + end,
+			[&](uint32 a, uint32 b) { return centers[a].elem(axis) < centers[b].elem(axis); });
+
+		_buildBVH(begin, mid, centers, index);
+		const uint32 right = _buildBVH(mid, end, centers, index);
+		m_bvh[index] = BVHNode{ vmin, vmax, right, 0 };
+		return index;
+	}
+
+	namespace detail
+	{
+		//点と箱の距離の2乗
+		inline float BoxDistanceSq(const Float3& p, const Float3& vmin, const Float3& vmax)
+		{
+			const Float3 d{ Max(Max(vmin.x - p.x, 0.0f), p.x - vmax.x),
+							Max(Max(vmin.y - p.y, 0.0f), p.y - vmax.y),
+							Max(Max(vmin.z - p.z, 0.0f), p.z - vmax.z) };
+			return d.lengthSq();
+		}
+
+		//線分 ab 上で p に最も近い点のパラメータ
+		inline float ClosestOnSegment(const Float3& p, const Float3& a, const Float3& b)
+		{
+			const Float3 ab = b - a;
+			const float lsq = ab.lengthSq();
+			return (lsq > 0) ? Clamp((p - a).dot(ab) / lsq, 0.0f, 1.0f) : 0.0f;
+		}
+
+		//半直線 o + s d (s∈[0,maxS]) と線分 a + t e (t∈[0,1]) の最接近パラメータ
+		inline std::pair<float, float> ClosestRaySegment(const Float3& o, const Float3& d, const float maxS, const Float3& a, const Float3& b)
+		{
+			const Float3 e = b - a;
+			const Float3 r = o - a;
+			const float dd = d.dot(d), ee = e.dot(e), de = d.dot(e), dr = d.dot(r), er = e.dot(r);
+			const float denom = dd * ee - de * de;
+
+			float s = (denom > 1e-12f) ? Clamp((de * er - dr * ee) / denom, 0.0f, maxS) : 0.0f;
+			float t = (ee > 0) ? (de * s + er) / ee : 0.0f;
+			if (t < 0.0f)
+			{
+				t = 0.0f;
+				s = Clamp(-dr / dd, 0.0f, maxS);
+			}
+			else if (t > 1.0f)
+			{
+				t = 1.0f;
+				s = Clamp((de - dr) / dd, 0.0f, maxS);
+			}
+			return { s, t };
+		}
+
+		//半直線と(radius で膨らませた)箱のスラブ判定
+		inline bool RayBox(const Float3& o, const Float3& invd, const float maxS, const Float3& vmin, const Float3& vmax, const float radius)
+		{
+			if (vmin.x > vmax.x) return false;		//捨てた線分だけの葉は空の箱
+
+			float s0 = 0.0f, s1 = maxS;
+			for (int32 aa = 0; aa < 3; aa++)
+			{
+				float ta = (vmin.elem(aa) - radius - o.elem(aa)) * invd.elem(aa);
+				float tb = (vmax.elem(aa) + radius - o.elem(aa)) * invd.elem(aa);
+				if (ta > tb) std::swap(ta, tb);
+				s0 = Max(s0, ta);
+				s1 = Min(s1, tb);
+				if (s0 > s1) return false;
+			}
+			return true;
+		}
+	}
+
+	CurveClosestPoint3D LineString3D::closestPoint(const Vec3& pos) const
+	{
+		if (size() < 2)
+		{
+			const Vec3 p = isEmpty() ? Vec3{ 0,0,0 } : front();
+			return CurveClosestPoint3D{ p, 0.0, p.distanceFrom(pos) };
+		}
+
+		_prepareBVH();
+
+		const Float3 p = pos;
+		const size_t hs = m_head * ArcSamples;
+		float bestSq = FLT_MAX;
+		uint32 bestLine = 0;
+		float bestT = 0;
+
+		const auto testLine = [&](const uint32 kk)
+		{
+			const Float3& a = m_samplePoints[kk];
+			const Float3& b = m_samplePoints[kk + 1];
+			const float t = detail::ClosestOnSegment(p, a, b);
+			const float dsq = (a.lerp(b, t) - p).lengthSq();
+			if (dsq < bestSq)
+			{
+				bestSq = dsq;
+				bestLine = kk;
+				bestT = t;
+			}
+		};
+
+		//木の外(appendPoint で足した線分)は全て調べる
+		for (uint32 kk = _firstPendingLine(); kk + 1 < m_samplePoints.size(); kk++) testLine(kk);
+
+		//近い子から辿り、最良距離より遠い箱は枝刈りする
+		uint32 stack[64];
+		int32 sp = 0;
+		stack[sp++] = 0;
+		while (sp > 0)
+		{
+			const BVHNode& node = m_bvh[stack[--sp]];
+			if (detail::BoxDistanceSq(p, node.min, node.max) >= bestSq) continue;
+
+			if (node.count)
+			{
+				for (uint32 ii = node.start; ii < node.start + node.count; ii++)
+				{
+					const uint32 kk = m_bvhIndex[ii];
+					if (kk >= hs) testLine(kk);
+				}
+				continue;
+			}
+
+			const uint32 left = (uint32)(&node - m_bvh.data()) + 1;
+			const uint32 right = node.start;
+			const float dl = detail::BoxDistanceSq(p, m_bvh[left].min, m_bvh[left].max);
+			const float dr = detail::BoxDistanceSq(p, m_bvh[right].min, m_bvh[right].max);
+			stack[sp++] = (dl < dr) ? right : left;
+			stack[sp++] = (dl < dr) ? left : right;
+		}
+
+		const double distance = m_arcLength[bestLine] - m_arcLength[hs] + bestT * (m_arcLength[bestLine + 1] - m_arcLength[bestLine]);
+		const Vec3 position = getPointAtDistance(distance);
+		return CurveClosestPoint3D{ position, (fullLength > 0) ? distance / fullLength : 0.0, position.distanceFrom(pos) };
+	}
+
+	bool LineString3D::intersects(const Sphere& sphere) const
+	{
+		if (isEmpty()) return false;
+		if (size() < 2) return front().distanceFromSq(sphere.center) <= sphere.r * sphere.r;
+
+		_prepareBVH();
+
+		const Float3 c = sphere.center;
+		const float rsq = (float)(sphere.r * sphere.r);
+		const size_t hs = m_head * ArcSamples;
+
+		const auto hitLine = [&](const uint32 kk)
+		{
+			const Float3& a = m_samplePoints[kk];
+			const Float3& b = m_samplePoints[kk + 1];
+			return (a.lerp(b, detail::ClosestOnSegment(c, a, b)) - c).lengthSq() <= rsq;
+		};
+
+		//木の外(appendPoint で足した線分)
+		for (uint32 kk = _firstPendingLine(); kk + 1 < m_samplePoints.size(); kk++)
+		{
+			if (hitLine(kk)) return true;
+		}
+
+		uint32 stack[64];
+		int32 sp = 0;
+		stack[sp++] = 0;
+		while (sp > 0)
+		{
+			const uint32 index = stack[--sp];
+			const BVHNode& node = m_bvh[index];
+			if (detail::BoxDistanceSq(c, node.min, node.max) > rsq) continue;
+
+			if (node.count)
+			{
+				for (uint32 ii = node.start; ii < node.start + node.count; ii++)
+				{
+					const uint32 kk = m_bvhIndex[ii];
+					if (kk >= hs && hitLine(kk)) return true;
+				}
+				continue;
+			}
+
+			stack[sp++] = node.start;
+			stack[sp++] = index + 1;
+		}
+		return false;
+	}
+
+	bool LineString3D::intersects(const Ray& ray, const double radius) const
+	{
+		return intersectsAt(ray, radius).has_value();
+	}
+
+	Optional<float> LineString3D::intersectsAt(const Ray& ray, const double radius) const
+	{
+		if (size() < 2) return none;
+
+		_prepareBVH();
+
+		const Float3 o = ray.origin;
+		const Float3 d = Float3{ ray.direction }.normalized();
+		const Float3 invd{ 1.0f / d.x, 1.0f / d.y, 1.0f / d.z };
+		const float r = (float)radius;
+
+		const size_t hs = m_head * ArcSamples;
+
+		//半直線は曲線全体の箱(木の外の線分を含む)を越える長さで打ち切る
+		Float3 vmin = m_bvh[0].min, vmax = m_bvh[0].max;
+		for (size_t kk = _firstPendingLine(); kk < m_samplePoints.size(); kk++)
+		{
+			const Float3& p = m_samplePoints[kk];
+			vmin = Float3{ Min(vmin.x, p.x), Min(vmin.y, p.y), Min(vmin.z, p.z) };
+			vmax = Float3{ Max(vmax.x, p.x), Max(vmax.y, p.y), Max(vmax.z, p.z) };
+		}
+		const float maxS = o.distanceFrom((vmin + vmax) / 2) + (vmax - vmin).length() + r;
+
+		float best = FLT_MAX;
+		const auto testLine = [&](const uint32 kk)
+		{
+			const Float3& a = m_samplePoints[kk];
+			const Float3& b = m_samplePoints[kk + 1];
+			const auto [s, t] = detail::ClosestRaySegment(o, d, maxS, a, b);
+			if ((o + d * s - a.lerp(b, t)).lengthSq() <= r * r && s < best) best = s;
+		};
+
+		//木の外(appendPoint で足した線分)
+		for (uint32 kk = _firstPendingLine(); kk + 1 < m_samplePoints.size(); kk++) testLine(kk);
+
+		uint32 stack[64];
+		int32 sp = 0;
+		stack[sp++] = 0;
+		while (sp > 0)
+		{
+			const uint32 index = stack[--sp];
+			const BVHNode& node = m_bvh[index];
+			if (!detail::RayBox(o, invd, Min(maxS, best), node.min, node.max, r)) continue;
+
+			if (node.count)
+			{
+				for (uint32 ii = node.start; ii < node.start + node.count; ii++)
+				{
+					const uint32 kk = m_bvhIndex[ii];
+					if (kk >= hs) testLine(kk);
+				}
+				continue;
+			}
+
+			stack[sp++] = node.start;
+			stack[sp++] = index + 1;
+		}
+
+		if (best == FLT_MAX) return none;
+		return best;
+	}
+
+	std::pair<size_t, double> LineString3D::_locate(double distance) const
+	{
+		_prepare();
+
+		const size_t hs = m_head * ArcSamples;
+		const size_t nsample = m_arcLength.size() - 1;
+		const double length = fullLength;
+		if (m_closed && length > 0)
+		{
+			distance -= std::floor(distance / length) * length;		//一周で巻き戻す
+		}
+		distance = Clamp(distance, 0.0, length) + m_arcLength[hs];
+
+		//二分探索で distance を含むサンプル区間を求める
+		size_t kk = std::upper_bound(m_arcLength.begin() + hs, m_arcLength.end(), distance) - m_arcLength.begin();
+		kk = (kk <= hs) ? hs : Min(kk - 1, nsample - 1);
+
+		const double len = m_arcLength[kk + 1] - m_arcLength[kk];
+		const double local = (len > 0) ? (distance - m_arcLength[kk]) / len : 0.0;
+
+		const size_t segment = kk / ArcSamples;
+		return { segment, ((kk % ArcSamples) + local) / ArcSamples };
+	}
+
+	double LineString3D::getLength() const
+	{
+		_prepare();
+
+		return fullLength;
+	}
+
+	Vec3 LineString3D::getPointAtDistance(const double distance) const
+	{
+		if (size() < 2) return isEmpty() ? Vec3{ 0,0,0 } : front();
+
+		const auto [segment, t] = _locate(distance);
+		return _evaluate(segment, t);
+	}
+
+	Vec3 LineString3D::getPointAtProgress(const double progress) const
+	{
+		return getPointAtDistance(progress * getLength());
+	}
+
+	Float3 LineString3D::getTangentAtProgress(const double progress) const
+	{
+		if (size() < 2) return Float3{ 0,0,1 };
+
+		const auto [segment, t] = _locate(progress * getLength());
+		const Float3 d = m_segments[segment].derivative((float)t);
+		return (d.lengthSq() > 0) ? d.normalized() : Float3{ 0,0,1 };
+	}
+
+	CurveFrame3D LineString3D::getFrameAt(const double progress) const
+	{
+		PIXIE_PROFILE("LineString3D::evaluate");
+		CurveFrame3D frame{ Float3{ 0,0,0 }, Float3{ 0,0,1 }, Float3{ 0,1,0 }, Float3{ -1,0,0 }, Quaternion::Identity() };
+		if (size() < 2)
+		{
+			if (!isEmpty()) frame.position = front();
+			return frame;
+		}
+
+		const auto [segment, t] = _locate(progress * getLength());
+		const CubicSegment3D& cs = m_segments[segment];
+		frame.position = cs.evaluate((float)t);
+
+		const Float3 d = cs.derivative((float)t);
+		if (d.lengthSq() > 0) frame.tangent = d.normalized();
+
+		//前後のサンプルの上方向を補間し、接線に直交化する
+		const double kf = segment * ArcSamples + t * ArcSamples;
+		const size_t k0 = Min((size_t)kf, m_frameUp.size() - 2);
+		const float w = (float)Clamp(kf - k0, 0.0, 1.0);
+		Float3 up = m_frameUp[k0].lerp(m_frameUp[k0 + 1], w);
+		up -= frame.tangent * frame.tangent.dot(up);
+		if (up.lengthSq() > 0) frame.up = up.normalized();
+
+		frame.right = frame.tangent.cross(frame.up);
+		frame.orientation = Quaternion::FromUnitVectorPairs({ Float3{ 0,0,1 }, Float3{ 0,1,0 } }, { -frame.tangent, frame.up });
+		return frame;
+	}
+
+	void LineString3D::getPointsAtProgress(const std::span<const double> progress, const std::span<Float3> positions, const std::span<Float3> tangents) const
+	{
+		PIXIE_PROFILE("LineString3D::evaluate");
+		using namespace DirectX;
+
+		const size_t num = Min(progress.size(), positions.size());
+		const bool withTangent = (tangents.size() >= num) && (num > 0);
+
+		if (size() < 2)
+		{
+			const Float3 p = isEmpty() ? Float3{ 0,0,0 } : Float3{ front() };
+			for (size_t i = 0; i < num; i++) positions[i] = p;
+			if (withTangent) for (size_t i = 0; i < num; i++) tangents[i] = Float3{ 0,0,0 };
+			return;
+		}
+
+		const double length = getLength();
+
+		//ブロック単位で (区間<<32 | 番号) を整列し、同じ区間の問い合わせを連続させる
+		constexpr size_t BLOCK = 256;
+		uint64 keys[BLOCK];
+		float params[BLOCK];
+
+		for (size_t base = 0; base < num; base += BLOCK)
+		{
+			const size_t nblock = Min(BLOCK, num - base);
+			for (size_t ii = 0; ii < nblock; ii++)
+			{
+				const auto [segment, t] = _locate(progress[base + ii] * length);
+				keys[ii] = (uint64(segment) << 32) | ii;
+				params[ii] = (float)t;
+			}
+			std::sort(keys, keys + nblock);
+
+			for (size_t run = 0; run < nblock; )
+			{
+				const uint32 segment = uint32(keys[run] >> 32);
+				size_t runend = run + 1;
+				while (runend < nblock && uint32(keys[runend] >> 32) == segment) runend++;
+
+				const CubicSegment3D& cs = m_segments[segment];
+				const XMVECTOR C0[3] = { XMVectorReplicate(cs.c0.x), XMVectorReplicate(cs.c0.y), XMVectorReplicate(cs.c0.z) };
+				const XMVECTOR C1[3] = { XMVectorReplicate(cs.c1.x), XMVectorReplicate(cs.c1.y), XMVectorReplicate(cs.c1.z) };
+				const XMVECTOR C2[3] = { XMVectorReplicate(cs.c2.x), XMVectorReplicate(cs.c2.y), XMVectorReplicate(cs.c2.z) };
+				const XMVECTOR C3[3] = { XMVectorReplicate(cs.c3.x), XMVectorReplicate(cs.c3.y), XMVectorReplicate(cs.c3.z) };
+
+				//同じ区間の4点を1レーンずつ並べて評価(端数は最後の点で埋める)
+				for (size_t kk = run; kk < runend; kk += 4)
+				{
+					uint32 index[4];
+					XMFLOAT4 t4;
+					float* tt = &t4.x;
+					for (size_t ll = 0; ll < 4; ll++)
+					{
+						index[ll] = uint32(keys[Min(kk + ll, runend - 1)] & 0xFFFFFFFF);
+						tt[ll] = params[index[ll]];
+					}
+					const XMVECTOR T = XMLoadFloat4(&t4);
+
+					XMFLOAT4 pos[3], tan[3];
+					for (size_t aa = 0; aa < 3; aa++)
+					{
+						//p(t) = ((c3 t + c2) t + c1) t + c0
+						XMVECTOR p = XMVectorMultiplyAdd(C3[aa], T, C2[aa]);
+						p = XMVectorMultiplyAdd(p, T, C1[aa]);
+						p = XMVectorMultiplyAdd(p, T, C0[aa]);
+						XMStoreFloat4(&pos[aa], p);
+
+						//p'(t) = (3 c3 t + 2 c2) t + c1
+						if (withTangent)
+						{
+							XMVECTOR d = XMVectorMultiplyAdd(XMVectorScale(C3[aa], 3.0f), T, XMVectorScale(C2[aa], 2.0f));
+							d = XMVectorMultiplyAdd(d, T, C1[aa]);
+							XMStoreFloat4(&tan[aa], d);
+						}
+					}
+
+					if (withTangent)
+					{
+						XMVECTOR dx = XMLoadFloat4(&tan[0]), dy = XMLoadFloat4(&tan[1]), dz = XMLoadFloat4(&tan[2]);
+						XMVECTOR len = XMVectorSqrt(XMVectorMultiplyAdd(dx, dx, XMVectorMultiplyAdd(dy, dy, XMVectorMultiply(dz, dz))));
+						len = XMVectorMax(len, XMVectorReplicate(1e-12f));
+						XMStoreFloat4(&tan[0], XMVectorDivide(dx, len));
+						XMStoreFloat4(&tan[1], XMVectorDivide(dy, len));
+						XMStoreFloat4(&tan[2], XMVectorDivide(dz, len));
+					}
+
+					const size_t lanes = Min<size_t>(4, runend - kk);
+					for (size_t ll = 0; ll < lanes; ll++)
+					{
+						const size_t dst = base + index[ll];
+						positions[dst] = Float3{ (&pos[0].x)[ll], (&pos[1].x)[ll], (&pos[2].x)[ll] };
+						if (withTangent) tangents[dst] = Float3{ (&tan[0].x)[ll], (&tan[1].x)[ll], (&tan[2].x)[ll] };
+					}
+				}
+				run = runend;
+			}
+		}
+	}
+
+	const LineString3D& LineString3D::_draw( const ColorF& color, const bool isClosed) const
+	{
+		if (size() < 2)
+		{
+			return *this;
+		}
+
+		for (size_t i = 0; i + 1 < size(); ++i)
+		{
+			Line3D(data()[i + 0], data()[i + 1]).draw(color) ;
+		}
+
+		if (isClosed)
+		{
+			Line3D(back(), front()).draw(color);
+		}
+
+		return *this;
+	}
+
+	void LineString3D::_tessellateSegment(const CubicSegment3D& segment, Array<Float3>& out) const
+	{
+		if (m_tessInterpolation == 0)
+		{
+			const auto f = [&](double t) { return Vec3{ segment.evaluate((float)t) }; };
+			AdaptiveSubdivide(f, 0.0, 1.0, f(0.0), f(1.0), m_tessTolerance, Math::Inf, out);
+			return;
+		}
+
+		for (int32 t = 0; t < m_tessInterpolation; ++t)
+		{
+			out.push_back(segment.evaluate(t / static_cast<float>(m_tessInterpolation)));
+		}
+	}
+
+	std::span<const Float3> LineString3D::_tessellate(const int32 interpolation, const double tolerance, const bool isClosed) const
+	{
+		if (m_tessellation && m_tessInterpolation == interpolation && m_tessTolerance == tolerance && m_tessClosed == isClosed)
+		{
+			return{ m_tessellation.data() + m_tessBegin, m_tessellation.size() - m_tessBegin };
+		}
+
+		PIXIE_PROFILE("LineString3D::tessellate");
+		m_tessInterpolation = interpolation;
+		m_tessTolerance = tolerance;
+		m_tessClosed = isClosed;
+		m_tessellation.clear();
+		m_tessOffset.clear();
+		m_tessBegin = 0;
+
+		if (!m_closed && isClosed)
+		{
+			//開いた線を閉じて描く。両端の区間も始端/終端延長ではなく巡回した制御点で引き、継ぎ目(終点→始点)の区間を足す
+			const std::ptrdiff_t n = size();
+			for (std::ptrdiff_t i = 0; i < n; i++)
+			{
+				m_tessOffset.push_back((uint32)m_tessellation.size());
+				_tessellateSegment(CatmullRomSegment(_controlPoint(i - 1, true), _controlPoint(i, true), _controlPoint(i + 1, true), _controlPoint(i + 2, true)), m_tessellation);
+			}
+			m_tessellation.push_back(front());
+			return m_tessellation;
+		}
+
+		//m_tessOffset は表と同じく捨てた先頭の区間の分も持つ
+		m_tessOffset.resize(m_head, 0);
+		for (size_t ss = m_head; ss < m_segments.size(); ss++)
+		{
+			m_tessOffset.push_back((uint32)m_tessellation.size());
+			_tessellateSegment(m_segments[ss], m_tessellation);
+		}
+
+		//閉曲線の継ぎ目の区間は m_segments に含まれている
+		m_tessellation.push_back(m_closed ? front() : back());
+
+		return m_tessellation;
+	}
+
+	void LineString3D::_drawCatmullRom( const ColorF& color, const int32 interpolation, const double tolerance, const bool isClosed) const
+	{
+		if (size() < 2 || interpolation < 0 || (interpolation == 0 && tolerance <= 0))
+		{
+			return;
+		}
+
+		_prepare();
+
+		//Line3D::draw はレンダラーの線リストに積まれ、まとめて1回で描画される
+		//キャッシュを読む間は appendPoint 等が書き換えないようにロックしたまま積む
+		std::lock_guard lock{ m_cacheMutex };
+		const std::span<const Float3> points = _tessellate(interpolation, tolerance, isClosed);
+		const Float3* p = points.data();
+		for (size_t i = 0; i + 1 < points.size(); ++i)
+		{
+			Line3D{ p[i], p[i + 1] }.draw(color);
+		}
+	}
+
+
+	void Formatter( FormatData& formatData, const LineString3D& value )
+	{
+		formatData.string.append(value.join(U", "_sv, U"("_sv, U")"_sv));
+	}
+}
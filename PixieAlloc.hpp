@@ -0,0 +1,128 @@
+﻿# pragma once
+
+# include <atomic>
+# include <cstdlib>
+# include <new>
+# include <Siv3D.hpp>
+
+//ヒープ確保回数のカウンタ(デバッグ用)
+//PIXIEALLOC_IMPLEMENTATION を定義した1つの翻訳単位だけで operator new を置き換える
+struct PixieAlloc
+{
+	static inline std::atomic<uint64> count{ 0 };
+	static inline std::atomic<uint64> bytes{ 0 };
+
+	static inline uint64 frameCount = 0;
+	static inline uint64 frameBytes = 0;
+	static inline uint64 lastCount = 0;
+	static inline uint64 lastBytes = 0;
+
+	static bool IsEnabled() noexcept
+	{
+# if defined(PIXIEALLOC_IMPLEMENTATION)
+		return true;
+# else
+		return false;
+# endif
+	}
+
+	//フレームの区切りで呼ぶ。直前フレームの確保回数とバイト数を確定する
+	static void NextFrame() noexcept
+	{
+		const uint64 c = count.load(std::memory_order_relaxed);
+		const uint64 b = bytes.load(std::memory_order_relaxed);
+		frameCount = c - lastCount;
+		frameBytes = b - lastBytes;
+		lastCount = c;
+		lastBytes = b;
+	}
+
+	static uint64 PerFrame() noexcept
+	{
+		return frameCount;
+	}
+
+	static uint64 BytesPerFrame() noexcept
+	{
+		return frameBytes;
+	}
+
+	static void Record(std::size_t size) noexcept
+	{
+		count.fetch_add(1, std::memory_order_relaxed);
+		bytes.fetch_add(size, std::memory_order_relaxed);
+	}
+};
+
+# if defined(PIXIEALLOC_IMPLEMENTATION)
+
+inline void* PixieAllocAligned(std::size_t size, std::size_t alignment)
+{
+#	if defined(_WIN32)
+	return _aligned_malloc(size, alignment);
+#	else
+	return std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+#	endif
+}
+
+inline void PixieFreeAligned(void* p) noexcept
+{
+#	if defined(_WIN32)
+	_aligned_free(p);
+#	else
+	std::free(p);
+#	endif
+}
+
+void* operator new(std::size_t size)
+{
+	PixieAlloc::Record(size);
+	if (void* p = std::malloc(size ? size : 1)) return p;
+	throw std::bad_alloc{};
+}
+
+void* operator new[](std::size_t size)
+{
+	PixieAlloc::Record(size);
+	if (void* p = std::malloc(size ? size : 1)) return p;
+	throw std::bad_alloc{};
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+	PixieAlloc::Record(size);
+	return std::malloc(size ? size : 1);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+	PixieAlloc::Record(size);
+	return std::malloc(size ? size : 1);
+}
+
+void* operator new(std::size_t size, std::align_val_t al)
+{
+	PixieAlloc::Record(size);
+	if (void* p = PixieAllocAligned(size ? size : 1, static_cast<std::size_t>(al))) return p;
+	throw std::bad_alloc{};
+}
+
+void* operator new[](std::size_t size, std::align_val_t al)
+{
+	PixieAlloc::Record(size);
+	if (void* p = PixieAllocAligned(size ? size : 1, static_cast<std::size_t>(al))) return p;
+	throw std::bad_alloc{};
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { PixieFreeAligned(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { PixieFreeAligned(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { PixieFreeAligned(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { PixieFreeAligned(p); }
+
+# endif
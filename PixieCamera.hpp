@@ -1,434 +1,584 @@
-﻿//-----------------------------------------------
-//
-//	This file is part of the Siv3D Engine.
-//
-//	Copyright (c) 2008-2021 Ryo Suzuki
-//	Copyright (c) 2016-2021 OpenSiv3D Project
-//
-//	Licensed under the MIT License.
-//
-//-----------------------------------------------
-
-# pragma once
-
-namespace s3d
-{
-	class alignas(16) PixieCamera //:public BasicCamera3D
-	{
-//	using BasicCamera3D::BasicCamera3D;
-
-	public:
-// from BasicCamera3D
-		static constexpr double DefaultVerticalFOV = 30_deg;
-		static constexpr double DefaultNearClip = 0.2;
-
-		virtual ~PixieCamera() = default;
-		PixieCamera() = default;
-		PixieCamera(const PixieCamera&) = default;
-		explicit PixieCamera(const Size& sceneSize, double verticalFOV = DefaultVerticalFOV,
-							  const Vec3& eyePosition = Vec3{ 0, 4, -4 },
-							  const Vec3& focusPosition = Vec3{ 0, 0, 0 },
-							  double nearClip = DefaultNearClip,
-							  const Vec3& upDirection = Vec3{ 0, 1, 0 }) noexcept
-			: m_sceneSize{ sceneSize }
-			, m_verticalFOV{ verticalFOV }
-			, m_nearClip{ nearClip }
-			, m_eyePos{ eyePosition }
-			, m_focusPos{ focusPosition }
-			, m_upDir{ upDirection }
-		{
-			updateProj();
-			updateView();
-			updateViewProj();
-		}
-
-		void setSceneSize(const Size& sceneSize) noexcept
-		{
-			m_sceneSize = sceneSize;
-			updateProj();
-			updateViewProj();
-		}
-
-		inline const Size& getSceneSize() const noexcept
-		{
-			return m_sceneSize;
-		}
-
-		void setProjection(const Size& sceneSize, double verticalFOV, double nearClip = DefaultNearClip) noexcept
-		{
-			m_sceneSize = sceneSize;
-			m_verticalFOV = verticalFOV;
-			m_nearClip = nearClip;
-
-			updateProj();
-			updateViewProj();
-		}
-
-		inline const Mat4x4& SIV3D_VECTOR_CALL getProj() const noexcept
-		{
-			return m_proj;
-		}
-
-		void setView(const Vec3& eyePosition, const Vec3& focusPosition, const Vec3& upDirection = Vec3{ 0, 1, 0 }) noexcept
-		{
-			m_eyePos = eyePosition;
-			m_focusPos = focusPosition;
-			m_upDir = upDirection;
-
-			updateView();
-			updateViewProj();
-		}
-		inline const Mat4x4& SIV3D_VECTOR_CALL getView() const noexcept
-		{
-			return m_view;
-		}
-
-		void setUpDirection(const Vec3& upDirection) noexcept
-		{
-			m_upDir = upDirection;
-			updateView();
-			updateViewProj();
-		}
-		inline const Vec3& getUpDirection() const noexcept
-		{
-			return m_upDir;
-		}
-
-		inline double getVerticlaFOV() const noexcept
-		{
-			return m_verticalFOV;
-		}
-
-		inline double getNearClip() const noexcept
-		{
-			return m_nearClip;
-		}
-
-		inline const Vec3& getEyePosition() const noexcept
-		{
-			return m_eyePos;
-		}
-
-		inline const Vec3& getFocusPosition() const noexcept
-		{
-			return m_focusPos;
-		}
-
-		Float3 worldToScreenPoint(const Float3& pos) const noexcept
-		{
-			Float3 v = SIMD_Float4{ DirectX::XMVector3TransformCoord(
-				                    SIMD_Float4{ pos, 0.0f }, m_viewProj) }.xyz();
-			v.x += 1.0f;
-			v.y += 1.0f;
-			v.x *= 0.5f * m_sceneSize.x;
-			v.y *= 0.5f;
-			v.y = 1.0f - v.y;
-			v.y *= m_sceneSize.y;
-			return v;
-		}
-
-		Float3 screenToWorldPoint(const Float2& pos, const float depth) const noexcept
-		{
-			Float3 v{ pos, depth };
-			v.x /= (m_sceneSize.x * 0.5f);
-			v.y /= (m_sceneSize.y * 0.5f);
-			v.x -= 1.0f;
-			v.y -= 1.0f;
-			v.y *= -1.0f;
-
-			const SIMD_Float4 worldPos = DirectX::XMVector3TransformCoord(
-				                         SIMD_Float4{ v, 0.0f }, m_invViewProj);
-			return worldPos.xyz();
-		}
-
-		Ray screenToRay(const Vec2& pos) const noexcept
-		{
-			const Vec3 rayEnd = screenToWorldPoint(pos, 0.1f);
-			return Ray{ m_eyePos, (rayEnd - m_eyePos).normalized() };
-		}
-
-		inline Vec3 getLookAtVector() const noexcept
-		{
-			return (m_focusPos - m_eyePos).normalized();
-		}
-
-		Quaternion getLookAtOrientation() const noexcept
-		{
-			return Quaternion::FromUnitVectorPairs( { Vec3::Forward(), Vec3::Up() },
-													{ getLookAtVector(), Vec3::Up() });
-		}
-
-		inline const Mat4x4& SIV3D_VECTOR_CALL getInvView() const noexcept
-		{
-			return m_invView;
-		}
-
-		inline const Mat4x4& SIV3D_VECTOR_CALL getViewProj() const noexcept
-		{
-			return m_viewProj;
-		}
-
-		const Mat4x4& SIV3D_VECTOR_CALL getInvViewProj() const noexcept
-		{
-			return m_invViewProj;
-		}
-
-		inline Mat4x4 billboard(const Float3 pos, const Float2 scale) const noexcept
-		{
-			Mat4x4 m = m_invView;
-			m.value.r[0] = DirectX::XMVectorScale(m.value.r[0], scale.x);
-			m.value.r[1] = DirectX::XMVectorScale(m.value.r[1], 1.0f);
-			m.value.r[2] = DirectX::XMVectorScale(m.value.r[2], scale.y);
-			m.value.r[3] = DirectX::XMVectorSet(pos.x, pos.y, pos.z, 1.0f);
-			return m;
-		}
-
-		void updateProj() noexcept
-		{
-			const double g = (1.0 / std::tan(m_verticalFOV * 0.5));
-			const double s = (static_cast<double>(m_sceneSize.x) / m_sceneSize.y);
-			constexpr float e = 0.000001f;
-
-			m_proj = Mat4x4{
-				static_cast<float>(g / s), 0.0f, 0.0f, 0.0f,
-				0.0f, static_cast<float>(g), 0.0f, 0.0f,
-				0.0f, 0.0f, e, 1.0f,
-				0.0f, 0.0f, static_cast<float>(m_nearClip * (1.0 - e)), 0.0f
-			};
-		}
-
-		void updateView() noexcept
-		{
-			const SIMD_Float4 eyePosition{ m_eyePos, 0.0f };
-			const SIMD_Float4 focusPosition{ m_focusPos, 0.0f };
-			const SIMD_Float4 upDirection{ m_upDir, 0.0f };
-			m_view = DirectX::XMMatrixLookAtLH(eyePosition, focusPosition, upDirection);
-			m_invView = m_view.inverse();
-		}
-
-		void updateViewProj() noexcept
-		{
-			m_viewProj = (m_view * m_proj);
-			m_invViewProj = m_viewProj.inverse();
-		}
-
-		Mat4x4 m_proj = Mat4x4::Identity();
-		Mat4x4 m_view = Mat4x4::Identity();
-		Mat4x4 m_invView = Mat4x4::Identity();
-		Mat4x4 m_viewProj = Mat4x4::Identity();
-		Mat4x4 m_invViewProj = Mat4x4::Identity();
-
-		Size m_sceneSize = Scene::DefaultSceneSize;
-		double m_verticalFOV = DefaultVerticalFOV;
-		double m_nearClip = DefaultNearClip;
-
-		Vec3 m_eyePos = Vec3{ 0, 4, -4 };
-		Vec3 m_focusPos = Vec3{ 0, 0, 0 };
-		Vec3 m_upDir = Vec3{ 0, 1, 0 };
-		Vec3 m_eyePosDelta = Vec3{ 0, 0, 0 };
-		Vec3 m_focusPosDelta = Vec3{ 0, 0, 0 };
-
-
-// itakawa added camerawork features
-
-		PixieCamera& setEyePosition(const Vec3& eyepos) noexcept
-		{
-			m_eyePos = eyepos;
-			return *this;
-		}
-
-		PixieCamera& setFocusPosition(const Vec3& focuspos) noexcept
-		{
-			m_focusPos = focuspos;
-			return *this;
-		}
-
-		inline const Vec3& getEyePosDelta() const noexcept
-		{
-			return m_eyePosDelta;
-		}
-
-		inline const Vec3& getFocusPosDelta() const noexcept
-		{
-			return m_focusPosDelta;
-		}
-
-		float getBasisSpeed()
-		{
-			Float3 distance = m_focusPos - m_eyePos;
-			Float3 identity = distance.normalized();
-			return distance.length() / identity.length() ;
-		}
-
-		bool dolly(float forwardback, bool movefocus )
-		{
-			Float3 dirB = (m_focusPos - m_eyePos).normalized();
-			m_eyePosDelta = forwardback * dirB;
-			m_focusPosDelta = m_eyePosDelta;
-
-			m_eyePos += m_eyePosDelta;
-			if (movefocus) m_focusPos = m_eyePos + dirB;
-			Float3 dirA = (m_focusPos - m_eyePos);
-
-			return ( Math::Sign(dirA.x) != Math::Sign(dirB.x) &&//目標点に達したら真を返す（止める等の処置をする）
-					 Math::Sign(dirA.y) != Math::Sign(dirB.y) &&
-					 Math::Sign(dirA.z) != Math::Sign(dirB.z));
-		}
-
-		PixieCamera& dolly( float forwardback )
-		{
-			Float3 dir = (m_focusPos - m_eyePos).normalized();
-			m_eyePosDelta = forwardback * dir;
-			m_focusPosDelta = m_eyePosDelta;
-			m_eyePos += m_eyePosDelta;
-			m_focusPos = m_eyePos + dir;
-			return *this;
-		}
-
-		PixieCamera& panX(float leftright)
-		{
-			Float3 forward = m_focusPos - m_eyePos;
-			Float3 dir = forward.normalized();
-			Float3 right = dir.cross(m_upDir);
-			m_upDir = right.cross(dir).normalized();
-
-			SIMD_Float4 qrot = DirectX::XMQuaternionRotationAxis(SIMD_Float4{ m_upDir, 0 }, leftright);
-			SIMD_Float4 focus = DirectX::XMVector3Rotate(SIMD_Float4{ forward, 0 }, qrot);
-
-			Float3 oldfocus = m_focusPos;
-			m_eyePosDelta = Float3{0,0,0};
-			m_focusPos = m_eyePos + focus.xyz() ;
-			m_focusPosDelta = m_focusPos - oldfocus;
-			return *this;
-		}
-
-		PixieCamera& panY(float updown)
-		{
-			Float3 forward = m_focusPos - m_eyePos;
-			Float3 dir = forward.normalized();
-			Float3 right = dir.cross(m_upDir);
-			m_upDir = right.cross(forward).normalized();
-
-			SIMD_Float4 qrot = DirectX::XMQuaternionRotationAxis(SIMD_Float4{ right, 0 }, updown);
-			SIMD_Float4 focus = DirectX::XMVector3Rotate(SIMD_Float4{ forward, 0 }, qrot);
-
-			Float3 oldfocus = m_focusPos;
-			m_eyePosDelta = Float3{ 0,0,0 };
-			m_focusPos = m_eyePos + focus.xyz() ;
-			m_focusPosDelta = m_focusPos - oldfocus;
-			return *this;
-		}
-
-		PixieCamera& tilt(float updown)
-		{
-			panY(updown);
-			return *this;
-		}
-
-		PixieCamera& trackX(float leftright)
-		{
-			Float3 fwd = m_focusPos - m_eyePos;
-			Float3 dir = fwd.normalized();
-			Float3 right = dir.cross(m_upDir).normalized();
-
-			dir = leftright * right;
-			m_eyePosDelta = dir;
-			m_focusPosDelta = dir;
-			m_eyePos += dir;
-			m_focusPos += dir;
-			return *this;
-		}
-
-		PixieCamera& craneY(float updown)
-		{
-			Float3 fwd = m_focusPos - m_eyePos;
-			Float3 dir = fwd.normalized();
-			Float3 right = dir.cross(m_upDir);
-			m_upDir = right.cross(dir).normalized();
-
-			dir = updown * m_upDir;
-			m_eyePosDelta = dir;
-			m_focusPosDelta = dir;
-			m_eyePos += dir;
-			m_focusPos += dir;
-			return *this;
-		}
-
-		PixieCamera& arcX(float leftright)
-		{
-			Float3 forward = m_eyePos - m_focusPos;
-			Float3 dir = (-forward).normalized();
-			Float3 right = m_upDir.cross(dir);
-			m_upDir = dir.cross(right).normalized();
-
-			SIMD_Float4 qrot = DirectX::XMQuaternionRotationAxis(SIMD_Float4{ m_upDir, 0 }, leftright);
-			SIMD_Float4 eye = DirectX::XMVector3Rotate(SIMD_Float4{ forward, 0 }, qrot);
-
-			Float3 oldeye = m_eyePos;
-			m_eyePos = eye.xyz() + m_focusPos;
-			m_eyePosDelta = m_eyePos - oldeye;
-			m_focusPosDelta = Float3{ 0,0,0 };
-			return *this;
-		}
-
-		PixieCamera& arcY(float updown)
-		{
-			Float3 forward = m_eyePos - m_focusPos;
-			Float3 dir = (-forward).normalized();
-			Float3 right = m_upDir.cross(dir);
-			m_upDir = dir.cross(right).normalized();
-
-			SIMD_Float4 qrot = DirectX::XMQuaternionRotationAxis(SIMD_Float4{ right, 0 }, updown);
-			SIMD_Float4 eye = DirectX::XMVector3Rotate(SIMD_Float4{ forward, 0 }, qrot);
-			Float3 oldeye = m_eyePos;
-			m_eyePos = eye.xyz() + m_focusPos;
-			m_eyePosDelta = m_eyePos - oldeye;
-			m_focusPosDelta = Float3{ 0,0,0 };
-			return *this;
-		}
-
-		Quaternion getQLookAt(const Float3& dst, const Float3& src,
-						      Float3* up = nullptr, Float3* right = nullptr) const//ポインタを指定する場合は結果を引数で取得
-		{
-			if (dst == src) return Quaternion::Identity();
-			Float3 _up = Float3{ 0,1,0 };
-			if (up != nullptr) _up = *up;
-
-			Float3 _forward = dst - src;
-			Float3 _dir = _forward.normalized();
-			if (_dir == _up) _dir += Float3{ 0.000001,0,0 };	//上と方向が同じ
-			Float3 _right = _dir.cross(_up).normalized();
-			_up = _dir.cross(_right).normalized();
-			if (up != nullptr)    *up = _up ;
-			if (right != nullptr) *right = _right;
-
-			return Quaternion::FromUnitVectorPairs( { Float3{0,0,1}, Float3{0,1,0} },
-				                                    { -_dir, -_up });
-		}
-
-		Quaternion getQForward() const
-		{
-			return getQLookAt(m_focusPos, m_eyePos );
-		}
-
-		Quaternion getQUp() const
-		{
-			return getQLookAt(m_upDir, m_eyePos );
-		}
-
-		Quaternion getQRight() const
-		{
-			Float3 forward = (m_focusPos - m_eyePos).normalized();
-			Float3 right = forward.cross(m_upDir).normalized();
-			return getQLookAt(right, m_eyePos);
-		}
-
-		Mat4x4 getMatInfront(Float3 pos, Float2 scale = Float2{1,1}, float distance = 5.0f) const
-		{
-			Float3 infront = ( m_eyePos - pos).normalized();
-			pos = infront * distance;
-			return billboard( pos, scale);
-		}
-
-	};
-}
+﻿//-----------------------------------------------
+//
+//	This file is part of the Siv3D Engine.
+//
+//	Copyright (c) 2008-2021 Ryo Suzuki
+//	Copyright (c) 2016-2021 OpenSiv3D Project
+//
+//	Licensed under the MIT License.
+//
+//-----------------------------------------------
+
+# pragma once
+
+namespace s3d
+{
+	//視錐台。6平面を4本ずつSoAで持ち(2本目は複製で埋める)、4平面同時に判定する
+	//平面は内向き法線で a x + b y + c z + d >= 0 が内側
+	struct alignas(16) PixieFrustum
+	{
+		DirectX::XMVECTOR a[2], b[2], c[2], d[2];
+
+		PixieFrustum() = default;
+
+		explicit PixieFrustum(const Mat4x4& viewProj) noexcept
+		{
+			using namespace DirectX;
+
+			//行ベクトル規約なので列から平面を取り出す(0 <= z <= w)
+			const XMMATRIX t = XMMatrixTranspose(viewProj.value);
+			XMVECTOR planes[8] = {
+				XMVectorAdd(t.r[3], t.r[0]), XMVectorSubtract(t.r[3], t.r[0]),
+				XMVectorAdd(t.r[3], t.r[1]), XMVectorSubtract(t.r[3], t.r[1]),
+				t.r[2], XMVectorSubtract(t.r[3], t.r[2]),
+			};
+			for (int32 i = 0; i < 6; i++) planes[i] = XMPlaneNormalize(planes[i]);
+			planes[6] = planes[0];
+			planes[7] = planes[1];
+
+			for (int32 k = 0; k < 2; k++)
+			{
+				XMMATRIX soa{ planes[k * 4 + 0], planes[k * 4 + 1], planes[k * 4 + 2], planes[k * 4 + 3] };
+				soa = XMMatrixTranspose(soa);
+				a[k] = soa.r[0]; b[k] = soa.r[1]; c[k] = soa.r[2]; d[k] = soa.r[3];
+			}
+		}
+
+		//中心 center、半径 radius の球が視錐台にかかるか
+		bool intersects(const Float3& center, float radius) const noexcept
+		{
+			using namespace DirectX;
+			const XMVECTOR cx = XMVectorReplicate(center.x), cy = XMVectorReplicate(center.y), cz = XMVectorReplicate(center.z);
+			const XMVECTOR r = XMVectorReplicate(-radius);
+
+			XMVECTOR outside = XMVectorFalseInt();
+			for (int32 k = 0; k < 2; k++)
+			{
+				const XMVECTOR dist = XMVectorMultiplyAdd(a[k], cx, XMVectorMultiplyAdd(b[k], cy, XMVectorMultiplyAdd(c[k], cz, d[k])));
+				outside = XMVectorOrInt(outside, XMVectorLess(dist, r));
+			}
+			return !XMVector4NotEqualInt(outside, XMVectorFalseInt());
+		}
+
+		bool intersects(const Sphere& sphere) const noexcept
+		{
+			return intersects(Float3{ sphere.center }, (float)sphere.r);
+		}
+
+		//OBBの平面方向の有効半径 |n・ax| hx + |n・ay| hy + |n・az| hz で中心の距離を判定する
+		bool intersects(const OrientedBox& box) const noexcept
+		{
+			using namespace DirectX;
+			const XMMATRIX rot = XMMatrixRotationQuaternion(box.orientation.value);
+			const Float3 half = Float3{ box.size } * 0.5f;
+			const XMVECTOR hx = XMVectorReplicate(half.x), hy = XMVectorReplicate(half.y), hz = XMVectorReplicate(half.z);
+			const XMVECTOR cx = XMVectorReplicate((float)box.center.x), cy = XMVectorReplicate((float)box.center.y), cz = XMVectorReplicate((float)box.center.z);
+
+			XMVECTOR outside = XMVectorFalseInt();
+			for (int32 k = 0; k < 2; k++)
+			{
+				XMVECTOR radius = XMVectorZero();
+				const XMVECTOR h[3] = { hx, hy, hz };
+				for (int32 ax = 0; ax < 3; ax++)
+				{
+					const XMVECTOR nx = XMVectorSplatX(rot.r[ax]), ny = XMVectorSplatY(rot.r[ax]), nz = XMVectorSplatZ(rot.r[ax]);
+					const XMVECTOR dot = XMVectorMultiplyAdd(a[k], nx, XMVectorMultiplyAdd(b[k], ny, XMVectorMultiply(c[k], nz)));
+					radius = XMVectorMultiplyAdd(XMVectorAbs(dot), h[ax], radius);
+				}
+				const XMVECTOR dist = XMVectorMultiplyAdd(a[k], cx, XMVectorMultiplyAdd(b[k], cy, XMVectorMultiplyAdd(c[k], cz, d[k])));
+				outside = XMVectorOrInt(outside, XMVectorLess(XMVectorAdd(dist, radius), XMVectorZero()));
+			}
+			return !XMVector4NotEqualInt(outside, XMVectorFalseInt());
+		}
+	};
+
+	class alignas(16) PixieCamera //:public BasicCamera3D
+	{
+//	using BasicCamera3D::BasicCamera3D;
+
+	public:
+// from BasicCamera3D
+		static constexpr double DefaultVerticalFOV = 30_deg;
+		static constexpr double DefaultNearClip = 0.2;
+
+		virtual ~PixieCamera() = default;
+		PixieCamera() = default;
+		PixieCamera(const PixieCamera&) = default;
+		explicit PixieCamera(const Size& sceneSize, double verticalFOV = DefaultVerticalFOV,
+							  const Vec3& eyePosition = Vec3{ 0, 4, -4 },
+							  const Vec3& focusPosition = Vec3{ 0, 0, 0 },
+							  double nearClip = DefaultNearClip,
+							  const Vec3& upDirection = Vec3{ 0, 1, 0 }) noexcept
+			: m_sceneSize{ sceneSize }
+			, m_verticalFOV{ verticalFOV }
+			, m_nearClip{ nearClip }
+			, m_eyePos{ eyePosition }
+			, m_focusPos{ focusPosition }
+			, m_upDir{ upDirection }
+		{
+		}
+
+		void setSceneSize(const Size& sceneSize) noexcept
+		{
+			m_sceneSize = sceneSize;
+			markProjDirty();
+		}
+
+		inline const Size& getSceneSize() const noexcept
+		{
+			return m_sceneSize;
+		}
+
+		void setProjection(const Size& sceneSize, double verticalFOV, double nearClip = DefaultNearClip) noexcept
+		{
+			m_sceneSize = sceneSize;
+			m_verticalFOV = verticalFOV;
+			m_nearClip = nearClip;
+			markProjDirty();
+		}
+
+		inline const Mat4x4& SIV3D_VECTOR_CALL getProj() const noexcept
+		{
+			if (m_dirty & DIRTY_PROJ) updateProj();
+			return m_proj;
+		}
+
+		void setView(const Vec3& eyePosition, const Vec3& focusPosition, const Vec3& upDirection = Vec3{ 0, 1, 0 }) noexcept
+		{
+			m_eyePos = eyePosition;
+			m_focusPos = focusPosition;
+			m_upDir = upDirection;
+			markViewDirty();
+		}
+		inline const Mat4x4& SIV3D_VECTOR_CALL getView() const noexcept
+		{
+			if (m_dirty & DIRTY_VIEW) updateView();
+			return m_view;
+		}
+
+		void setUpDirection(const Vec3& upDirection) noexcept
+		{
+			m_upDir = upDirection;
+			markViewDirty();
+		}
+		inline const Vec3& getUpDirection() const noexcept
+		{
+			return m_upDir;
+		}
+
+		inline double getVerticlaFOV() const noexcept
+		{
+			return m_verticalFOV;
+		}
+
+		inline double getNearClip() const noexcept
+		{
+			return m_nearClip;
+		}
+
+		inline const Vec3& getEyePosition() const noexcept
+		{
+			return m_eyePos;
+		}
+
+		inline const Vec3& getFocusPosition() const noexcept
+		{
+			return m_focusPos;
+		}
+
+		Float3 worldToScreenPoint(const Float3& pos) const noexcept
+		{
+			Float3 v = SIMD_Float4{ DirectX::XMVector3TransformCoord(
+				                    SIMD_Float4{ pos, 0.0f }, getViewProj()) }.xyz();
+			v.x += 1.0f;
+			v.y += 1.0f;
+			v.x *= 0.5f * m_sceneSize.x;
+			v.y *= 0.5f;
+			v.y = 1.0f - v.y;
+			v.y *= m_sceneSize.y;
+			return v;
+		}
+
+		Float3 screenToWorldPoint(const Float2& pos, const float depth) const noexcept
+		{
+			Float3 v{ pos, depth };
+			v.x /= (m_sceneSize.x * 0.5f);
+			v.y /= (m_sceneSize.y * 0.5f);
+			v.x -= 1.0f;
+			v.y -= 1.0f;
+			v.y *= -1.0f;
+
+			const SIMD_Float4 worldPos = DirectX::XMVector3TransformCoord(
+				                         SIMD_Float4{ v, 0.0f }, getInvViewProj());
+			return worldPos.xyz();
+		}
+
+		Ray screenToRay(const Vec2& pos) const noexcept
+		{
+			const Vec3 rayEnd = screenToWorldPoint(pos, 0.1f);
+			return Ray{ m_eyePos, (rayEnd - m_eyePos).normalized() };
+		}
+
+		inline Vec3 getLookAtVector() const noexcept
+		{
+			return (m_focusPos - m_eyePos).normalized();
+		}
+
+		Quaternion getLookAtOrientation() const noexcept
+		{
+			return Quaternion::FromUnitVectorPairs( { Vec3::Forward(), Vec3::Up() },
+													{ getLookAtVector(), Vec3::Up() });
+		}
+
+		inline const Mat4x4& SIV3D_VECTOR_CALL getInvView() const noexcept
+		{
+			if (m_dirty & DIRTY_INVVIEW) updateInvView();
+			return m_invView;
+		}
+
+		inline const Mat4x4& SIV3D_VECTOR_CALL getViewProj() const noexcept
+		{
+			if (m_dirty & DIRTY_VIEWPROJ) updateViewProj();
+			return m_viewProj;
+		}
+
+		const Mat4x4& SIV3D_VECTOR_CALL getInvViewProj() const noexcept
+		{
+			if (m_dirty & DIRTY_INVVIEWPROJ) updateInvViewProj();
+			return m_invViewProj;
+		}
+
+		const PixieFrustum& getFrustum() const noexcept
+		{
+			if (m_dirty & DIRTY_FRUSTUM)
+			{
+				m_frustum = PixieFrustum{ getViewProj() };
+				m_dirty &= ~DIRTY_FRUSTUM;
+			}
+			return m_frustum;
+		}
+
+		inline Mat4x4 billboard(const Float3 pos, const Float2 scale) const noexcept
+		{
+			Mat4x4 m = getInvView();
+			m.value.r[0] = DirectX::XMVectorScale(m.value.r[0], scale.x);
+			m.value.r[1] = DirectX::XMVectorScale(m.value.r[1], scale.y);
+			m.value.r[2] = DirectX::XMVectorScale(m.value.r[2], scale.y);
+			m.value.r[3] = DirectX::XMVectorSet(pos.x, pos.y, pos.z, 1.0f);
+			return m;
+		}
+
+		// 行列は変更時に印を付けるだけで、次に読まれたときに計算する
+		// 視点や注視点を m_eyePos 等へ直接書いた場合は setView/setEyePosition を使うか markViewDirty() を呼ぶ
+		enum : uint8
+		{
+			DIRTY_PROJ = 1,
+			DIRTY_VIEW = 2,
+			DIRTY_INVVIEW = 4,
+			DIRTY_VIEWPROJ = 8,
+			DIRTY_INVVIEWPROJ = 16,
+			DIRTY_FRUSTUM = 32,
+			DIRTY_ALL = 63,
+		};
+
+		void markViewDirty() noexcept
+		{
+			m_dirty |= DIRTY_VIEW | DIRTY_INVVIEW | DIRTY_VIEWPROJ | DIRTY_INVVIEWPROJ | DIRTY_FRUSTUM;
+		}
+
+		void markProjDirty() noexcept
+		{
+			m_dirty |= DIRTY_PROJ | DIRTY_VIEWPROJ | DIRTY_INVVIEWPROJ | DIRTY_FRUSTUM;
+		}
+
+		void updateProj() const noexcept
+		{
+			const double g = (1.0 / std::tan(m_verticalFOV * 0.5));
+			const double s = (static_cast<double>(m_sceneSize.x) / m_sceneSize.y);
+			constexpr float e = 0.000001f;
+
+			m_proj = Mat4x4{
+				static_cast<float>(g / s), 0.0f, 0.0f, 0.0f,
+				0.0f, static_cast<float>(g), 0.0f, 0.0f,
+				0.0f, 0.0f, e, 1.0f,
+				0.0f, 0.0f, static_cast<float>(m_nearClip * (1.0 - e)), 0.0f
+			};
+			m_dirty &= ~DIRTY_PROJ;
+		}
+
+		void updateView() const noexcept
+		{
+			const SIMD_Float4 eyePosition{ m_eyePos, 0.0f };
+			const SIMD_Float4 focusPosition{ m_focusPos, 0.0f };
+			const SIMD_Float4 upDirection{ m_upDir, 0.0f };
+			m_view = DirectX::XMMatrixLookAtLH(eyePosition, focusPosition, upDirection);
+			m_dirty &= ~DIRTY_VIEW;
+		}
+
+		//ビュー行列は正規直交基底+平行移動なので、逆行列は回転部の転置と視点位置で作れる
+		void updateInvView() const noexcept
+		{
+			DirectX::XMMATRIX m = getView().value;
+			m.r[3] = DirectX::g_XMIdentityR3;
+			m = DirectX::XMMatrixTranspose(m);
+			m.r[3] = DirectX::XMVectorSet((float)m_eyePos.x, (float)m_eyePos.y, (float)m_eyePos.z, 1.0f);
+			m_invView = m;
+			m_dirty &= ~DIRTY_INVVIEW;
+		}
+
+		void updateViewProj() const noexcept
+		{
+			m_viewProj = (getView() * getProj());
+			m_dirty &= ~DIRTY_VIEWPROJ;
+		}
+
+		//(V P)^-1 = P^-1 V^-1。透視投影の逆行列も成分から直接求める
+		void updateInvViewProj() const noexcept
+		{
+			const Mat4x4& proj = getProj();
+			const float a = DirectX::XMVectorGetX(proj.value.r[0]);
+			const float b = DirectX::XMVectorGetY(proj.value.r[1]);
+			const float e = DirectX::XMVectorGetZ(proj.value.r[2]);
+			const float c = DirectX::XMVectorGetZ(proj.value.r[3]);
+			const Mat4x4 invProj{
+				1.0f / a, 0.0f, 0.0f, 0.0f,
+				0.0f, 1.0f / b, 0.0f, 0.0f,
+				0.0f, 0.0f, 0.0f, 1.0f / c,
+				0.0f, 0.0f, 1.0f, -e / c
+			};
+			m_invViewProj = invProj * getInvView();
+			m_dirty &= ~DIRTY_INVVIEWPROJ;
+		}
+
+		mutable Mat4x4 m_proj = Mat4x4::Identity();
+		mutable Mat4x4 m_view = Mat4x4::Identity();
+		mutable Mat4x4 m_invView = Mat4x4::Identity();
+		mutable Mat4x4 m_viewProj = Mat4x4::Identity();
+		mutable Mat4x4 m_invViewProj = Mat4x4::Identity();
+		mutable PixieFrustum m_frustum;
+		mutable uint8 m_dirty = DIRTY_ALL;
+
+		Size m_sceneSize = Scene::DefaultSceneSize;
+		double m_verticalFOV = DefaultVerticalFOV;
+		double m_nearClip = DefaultNearClip;
+
+		Vec3 m_eyePos = Vec3{ 0, 4, -4 };
+		Vec3 m_focusPos = Vec3{ 0, 0, 0 };
+		Vec3 m_upDir = Vec3{ 0, 1, 0 };
+		Vec3 m_eyePosDelta = Vec3{ 0, 0, 0 };
+		Vec3 m_focusPosDelta = Vec3{ 0, 0, 0 };
+
+
+// itakawa added camerawork features
+
+		PixieCamera& setEyePosition(const Vec3& eyepos) noexcept
+		{
+			m_eyePos = eyepos;
+			markViewDirty();
+			return *this;
+		}
+
+		PixieCamera& setFocusPosition(const Vec3& focuspos) noexcept
+		{
+			m_focusPos = focuspos;
+			markViewDirty();
+			return *this;
+		}
+
+		inline const Vec3& getEyePosDelta() const noexcept
+		{
+			return m_eyePosDelta;
+		}
+
+		inline const Vec3& getFocusPosDelta() const noexcept
+		{
+			return m_focusPosDelta;
+		}
+
+		float getBasisSpeed()
+		{
+			Float3 distance = m_focusPos - m_eyePos;
+			Float3 identity = distance.normalized();
+			return distance.length() / identity.length() ;
+		}
+
+		bool dolly(float forwardback, bool movefocus )
+		{
+			Float3 dirB = (m_focusPos - m_eyePos).normalized();
+			m_eyePosDelta = forwardback * dirB;
+			m_focusPosDelta = m_eyePosDelta;
+
+			m_eyePos += m_eyePosDelta;
+			if (movefocus) m_focusPos = m_eyePos + dirB;
+			markViewDirty();
+			Float3 dirA = (m_focusPos - m_eyePos);
+
+			return ( Math::Sign(dirA.x) != Math::Sign(dirB.x) &&//目標点に達したら真を返す（止める等の処置をする）
+					 Math::Sign(dirA.y) != Math::Sign(dirB.y) &&
+					 Math::Sign(dirA.z) != Math::Sign(dirB.z));
+		}
+
+		PixieCamera& dolly( float forwardback )
+		{
+			Float3 dir = (m_focusPos - m_eyePos).normalized();
+			m_eyePosDelta = forwardback * dir;
+			m_focusPosDelta = m_eyePosDelta;
+			m_eyePos += m_eyePosDelta;
+			m_focusPos = m_eyePos + dir;
+			markViewDirty();
+			return *this;
+		}
+
+		PixieCamera& panX(float leftright)
+		{
+			Float3 forward = m_focusPos - m_eyePos;
+			Float3 dir = forward.normalized();
+			Float3 right = dir.cross(m_upDir);
+			m_upDir = right.cross(dir).normalized();
+
+			SIMD_Float4 qrot = DirectX::XMQuaternionRotationAxis(SIMD_Float4{ m_upDir, 0 }, leftright);
+			SIMD_Float4 focus = DirectX::XMVector3Rotate(SIMD_Float4{ forward, 0 }, qrot);
+
+			Float3 oldfocus = m_focusPos;
+			m_eyePosDelta = Float3{0,0,0};
+			m_focusPos = m_eyePos + focus.xyz() ;
+			m_focusPosDelta = m_focusPos - oldfocus;
+			markViewDirty();
+			return *this;
+		}
+
+		PixieCamera& panY(float updown)
+		{
+			Float3 forward = m_focusPos - m_eyePos;
+			Float3 dir = forward.normalized();
+			Float3 right = dir.cross(m_upDir);
+			m_upDir = right.cross(forward).normalized();
+
+			SIMD_Float4 qrot = DirectX::XMQuaternionRotationAxis(SIMD_Float4{ right, 0 }, updown);
+			SIMD_Float4 focus = DirectX::XMVector3Rotate(SIMD_Float4{ forward, 0 }, qrot);
+
+			Float3 oldfocus = m_focusPos;
+			m_eyePosDelta = Float3{ 0,0,0 };
+			m_focusPos = m_eyePos + focus.xyz() ;
+			m_focusPosDelta = m_focusPos - oldfocus;
+			markViewDirty();
+			return *this;
+		}
+
+		PixieCamera& tilt(float updown)
+		{
+			panY(updown);
+			return *this;
+		}
+
+		PixieCamera& trackX(float leftright)
+		{
+			Float3 fwd = m_focusPos - m_eyePos;
+			Float3 dir = fwd.normalized();
+			Float3 right = dir.cross(m_upDir).normalized();
+
+			dir = leftright * right;
+			m_eyePosDelta = dir;
+			m_focusPosDelta = dir;
+			m_eyePos += dir;
+			m_focusPos += dir;
+			markViewDirty();
+			return *this;
+		}
+
+		PixieCamera& craneY(float updown)
+		{
+			Float3 fwd = m_focusPos - m_eyePos;
+			Float3 dir = fwd.normalized();
+			Float3 right = dir.cross(m_upDir);
+			m_upDir = right.cross(dir).normalized();
+
+			dir = updown * m_upDir;
+			m_eyePosDelta = dir;
+			m_focusPosDelta = dir;
+			m_eyePos += dir;
+			m_focusPos += dir;
+			markViewDirty();
+			return *this;
+		}
+
+		PixieCamera& arcX(float leftright)
+		{
+			Float3 forward = m_eyePos - m_focusPos;
+			Float3 dir = (-forward).normalized();
+			Float3 right = m_upDir.cross(dir);
+			m_upDir = dir.cross(right).normalized();
+
+			SIMD_Float4 qrot = DirectX::XMQuaternionRotationAxis(SIMD_Float4{ m_upDir, 0 }, leftright);
+			SIMD_Float4 eye = DirectX::XMVector3Rotate(SIMD_Float4{ forward, 0 }, qrot);
+
+			Float3 oldeye = m_eyePos;
+			m_eyePos = eye.xyz() + m_focusPos;
+			m_eyePosDelta = m_eyePos - oldeye;
+			m_focusPosDelta = Float3{ 0,0,0 };
+			markViewDirty();
+			return *this;
+		}
+
+		PixieCamera& arcY(float updown)
+		{
+			Float3 forward = m_eyePos - m_focusPos;
+			Float3 dir = (-forward).normalized();
+			Float3 right = m_upDir.cross(dir);
+			m_upDir = dir.cross(right).normalized();
+
+			SIMD_Float4 qrot = DirectX::XMQuaternionRotationAxis(SIMD_Float4{ right, 0 }, updown);
+			SIMD_Float4 eye = DirectX::XMVector3Rotate(SIMD_Float4{ forward, 0 }, qrot);
+			Float3 oldeye = m_eyePos;
+			m_eyePos = eye.xyz() + m_focusPos;
+			m_eyePosDelta = m_eyePos - oldeye;
+			m_focusPosDelta = Float3{ 0,0,0 };
+			markViewDirty();
+			return *this;
+		}
+
+		Quaternion getQLookAt(const Float3& dst, const Float3& src,
+						      Float3* up = nullptr, Float3* right = nullptr) const//ポインタを指定する場合は結果を引数で取得
+		{
+			if (dst == src) return Quaternion::Identity();
+			Float3 _up = Float3{ 0,1,0 };
+			if (up != nullptr) _up = *up;
+
+			Float3 _forward = dst - src;
+			Float3 _dir = _forward.normalized();
+			if (_dir == _up) _dir += Float3{ 0.000001,0,0 };	//上と方向が同じ
+			Float3 _right = _dir.cross(_up).normalized();
+			_up = _dir.cross(_right).normalized();
+			if (up != nullptr)    *up = _up ;
+			if (right != nullptr) *right = _right;
+
+			return Quaternion::FromUnitVectorPairs( { Float3{0,0,1}, Float3{0,1,0} },
+				                                    { -_dir, -_up });
+		}
+
+		Quaternion getQForward() const
+		{
+			return getQLookAt(m_focusPos, m_eyePos );
+		}
+
+		Quaternion getQUp() const
+		{
+			return getQLookAt(m_upDir, m_eyePos );
+		}
+
+		Quaternion getQRight() const
+		{
+			Float3 forward = (m_focusPos - m_eyePos).normalized();
+			Float3 right = forward.cross(m_upDir).normalized();
+			return getQLookAt(right, m_eyePos);
+		}
+
+		Mat4x4 getMatInfront(Float3 pos, Float2 scale = Float2{1,1}, float distance = 5.0f) const
+		{
+			Float3 infront = ( m_eyePos - pos).normalized();
+			pos = infront * distance;
+			return billboard( pos, scale);
+		}
+
+	};
+}
@@ -0,0 +1,214 @@
+﻿# pragma once
+
+# include <atomic>
+# include <condition_variable>
+# include <deque>
+# include <functional>
+# include <memory>
+# include <mutex>
+# include <span>
+# include <thread>
+# include <Siv3D.hpp>
+
+//依存関係付きのジョブグラフ。フレームループの前に1度だけ組み、PixieJobs::run() で毎回同じグラフを実行する
+class PixieJobGraph
+{
+public:
+	using JobID = uint32;
+
+private:
+	friend class PixieJobs;
+
+	struct Job
+	{
+		std::function<void()>	func;
+		Array<JobID>			successors;
+		uint32					numDeps = 0;
+		std::atomic<uint32>		pending{ 0 };
+	};
+
+	Array<std::unique_ptr<Job>>	jobs;
+
+public:
+	//depsが全て終わってから実行するジョブを加える
+	JobID add(std::function<void()> func, std::initializer_list<JobID> deps = {})
+	{
+		return add(std::move(func), std::span<const JobID>{ deps.begin(), deps.size() });
+	}
+
+	JobID add(std::function<void()> func, std::span<const JobID> deps)
+	{
+		const JobID id = (JobID)jobs.size();
+		auto& job = jobs.emplace_back(std::make_unique<Job>());
+		job->func = std::move(func);
+		job->numDeps = (uint32)deps.size();
+		for (const JobID d : deps) jobs[d]->successors.emplace_back(id);
+		return id;
+	}
+
+	//[0,count)をgrain個ずつのジョブに分けて f(begin, end) を実行する。全チャンクの完了を表すジョブを返す
+	template <class Fty>
+	JobID addParallel(size_t count, size_t grain, Fty f, std::initializer_list<JobID> deps = {})
+	{
+		grain = Max<size_t>(grain, 1);
+		Array<JobID> chunks;
+		for (size_t begin = 0; begin < count; begin += grain)
+		{
+			const size_t end = Min(begin + grain, count);
+			chunks.emplace_back(add([f, begin, end] { f(begin, end); }, deps));
+		}
+		return add(nullptr, chunks);
+	}
+
+	size_t size() const noexcept { return jobs.size(); }
+	bool isEmpty() const noexcept { return jobs.isEmpty(); }
+
+	void clear()
+	{
+		jobs.clear();
+	}
+};
+
+//ジョブグラフを実行するワークスティーリング方式のジョブシステム。run() を呼んだスレッドもワーカーとして働く
+//各ワーカーは自分のキューの末尾から取り(直前に実行可能になった後続を優先)、空なら他のワーカーのキューの先頭から盗む
+class PixieJobs
+{
+public:
+	using JobID = PixieJobGraph::JobID;
+
+private:
+	struct Queue
+	{
+		std::mutex				mutex;
+		std::deque<JobID>		jobs;
+	};
+
+	Array<std::unique_ptr<Queue>>	queues;			//[0]はrun()を呼んだスレッド
+	Array<std::thread>				threads;
+	PixieJobGraph*					graph = nullptr;
+
+	std::atomic<uint32>				remaining{ 0 };
+	std::atomic<bool>				running{ false };
+	bool							quit = false;
+	std::mutex						wakeMutex;
+	std::condition_variable			wake;
+
+	void push(uint32 worker, JobID id)
+	{
+		Queue& q = *queues[worker];
+		std::lock_guard lock{ q.mutex };
+		q.jobs.push_back(id);
+	}
+
+	bool pop(uint32 worker, JobID& id)
+	{
+		{
+			Queue& q = *queues[worker];
+			std::lock_guard lock{ q.mutex };
+			if (!q.jobs.empty())
+			{
+				id = q.jobs.back();
+				q.jobs.pop_back();
+				return true;
+			}
+		}
+
+		for (size_t k = 1; k < queues.size(); k++)
+		{
+			Queue& q = *queues[(worker + k) % queues.size()];
+			std::lock_guard lock{ q.mutex };
+			if (!q.jobs.empty())
+			{
+				id = q.jobs.front();
+				q.jobs.pop_front();
+				return true;
+			}
+		}
+		return false;
+	}
+
+	bool execute(uint32 worker)
+	{
+		JobID id;
+		if (!pop(worker, id)) return false;
+
+		auto& jobs = graph->jobs;
+		auto& job = *jobs[id];
+		if (job.func) job.func();
+
+		for (const JobID s : job.successors)
+		{
+			if (jobs[s]->pending.fetch_sub(1, std::memory_order_acq_rel) == 1) push(worker, s);
+		}
+		remaining.fetch_sub(1, std::memory_order_release);
+		return true;
+	}
+
+	void workerMain(uint32 worker)
+	{
+		for (;;)
+		{
+			{
+				std::unique_lock lock{ wakeMutex };
+				wake.wait(lock, [&] { return quit || running.load(); });
+				if (quit) return;
+			}
+
+			while (running.load(std::memory_order_acquire))
+			{
+				if (!execute(worker)) std::this_thread::yield();
+			}
+		}
+	}
+
+public:
+	//numThreadsはrun()を呼ぶスレッドを含まないワーカー数
+	explicit PixieJobs(size_t numThreads = Max(1u, std::thread::hardware_concurrency()) - 1)
+	{
+		for (size_t i = 0; i <= numThreads; i++) queues.emplace_back(std::make_unique<Queue>());
+		for (size_t i = 1; i <= numThreads; i++) threads.emplace_back(&PixieJobs::workerMain, this, (uint32)i);
+	}
+
+	~PixieJobs()
+	{
+		{
+			std::lock_guard lock{ wakeMutex };
+			quit = true;
+		}
+		wake.notify_all();
+		for (auto& th : threads) th.join();
+	}
+
+	PixieJobs(const PixieJobs&) = delete;
+	PixieJobs& operator =(const PixieJobs&) = delete;
+
+	size_t num_workers() const noexcept { return queues.size(); }
+
+	//グラフ全体を実行して終わるまで待つ
+	void run(PixieJobGraph& g)
+	{
+		if (g.isEmpty()) return;
+
+		graph = &g;
+		remaining.store((uint32)g.jobs.size(), std::memory_order_relaxed);
+		uint32 next = 0;
+		for (JobID id = 0; id < g.jobs.size(); id++)
+		{
+			auto& job = *g.jobs[id];
+			job.pending.store(job.numDeps, std::memory_order_relaxed);
+			if (job.numDeps == 0) push(next++ % queues.size(), id);
+		}
+
+		{
+			std::lock_guard lock{ wakeMutex };
+			running.store(true, std::memory_order_release);
+		}
+		wake.notify_all();
+
+		while (remaining.load(std::memory_order_acquire) > 0)
+		{
+			if (!execute(0)) std::this_thread::yield();
+		}
+		running.store(false, std::memory_order_release);
+	}
+};
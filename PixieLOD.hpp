@@ -0,0 +1,293 @@
+﻿# pragma once
+
+# include <numeric>
+# include <queue>
+# include <Siv3D.hpp>
+
+//LOD用のメッシュ簡略化(二次誤差による辺の縮約)
+//縮約は残す側の頂点へ寄せる半辺縮約なので、結果は元の頂点の部分集合と新しいインデックスで表せる
+//同じ頂点配置を持つ焼いたフレームには apply() で同じ簡略化をそのまま当てられる
+struct PixieLOD
+{
+	Array<uint32>			vertices;		//残す元の頂点番号
+	Array<TriangleIndex32>	indices;		//vertices に対するインデックス
+	size_t					numSourceVertices = 0;	//元の頂点数(apply() に渡す頂点列と揃っていること)
+
+	bool isEmpty() const noexcept { return indices.isEmpty(); }
+
+	//元と同じ頂点配置の頂点列から簡略版を作る
+	MeshData apply(const Array<Vertex3D>& src) const
+	{
+		Array<Vertex3D> dst(vertices.size());
+		for (size_t i = 0; i < vertices.size(); i++) dst[i] = src[vertices[i]];
+		return MeshData{ std::move(dst), indices };
+	}
+
+	//三角形数を ratio 倍まで減らす。減らせなければ空を返す
+	//法線やUVで分割された頂点は位置で束ねて縮約し、三角形は寄せた先の位置で属性の近い頂点に付け替える
+	//開いた縁の頂点は輪郭を保つために動かさない
+	static PixieLOD Simplify(const MeshData& md, double ratio)
+	{
+		const Array<Vertex3D>& verts = md.vertices;
+		const Array<TriangleIndex32>& tris = md.indices;
+		const size_t target = (size_t)(tris.size() * ratio);
+		if (tris.isEmpty() || target >= tris.size()) return{};
+
+		//同じ位置の頂点を束ねる
+		Array<uint32> order(verts.size());
+		std::iota(order.begin(), order.end(), 0u);
+		std::sort(order.begin(), order.end(), [&](uint32 a, uint32 b)
+		{
+			const Float3& pa = verts[a].pos;
+			const Float3& pb = verts[b].pos;
+			if (pa.x != pb.x) return pa.x < pb.x;
+			if (pa.y != pb.y) return pa.y < pb.y;
+			return pa.z < pb.z;
+		});
+
+		Array<uint32> group(verts.size());
+		Array<Float3> position;
+		Array<Array<uint32>> groupVerts;
+		for (size_t i = 0; i < order.size(); i++)
+		{
+			if (i == 0 || verts[order[i]].pos != verts[order[i - 1]].pos)
+			{
+				position.emplace_back(verts[order[i]].pos);
+				groupVerts.emplace_back();
+			}
+			group[order[i]] = (uint32)(position.size() - 1);
+			groupVerts.back().emplace_back(order[i]);
+		}
+		const size_t numgroups = position.size();
+
+		//面の二次誤差を頂点に集める(面積で重み付け)
+		Array<Quadric> quadric(numgroups);
+		Array<Array<uint32>> groupTris(numgroups);
+		Array<uint64> edges;
+		edges.reserve(tris.size() * 3);
+		for (uint32 t = 0; t < tris.size(); t++)
+		{
+			const uint32 g[3] = { group[tris[t].i0], group[tris[t].i1], group[tris[t].i2] };
+			const Vec3 p0 = position[g[0]], p1 = position[g[1]], p2 = position[g[2]];
+			const Vec3 n = (p1 - p0).cross(p2 - p0);
+			const double area2 = n.length();
+			if (area2 > 0)
+			{
+				const Vec3 un = n / area2;
+				const Quadric q = Quadric::FromPlane(un.x, un.y, un.z, -un.dot(p0), area2 / 2);
+				for (uint32 k = 0; k < 3; k++) quadric[g[k]] += q;
+			}
+
+			for (uint32 k = 0; k < 3; k++)
+			{
+				if ((k < 1 || g[k] != g[0]) && (k < 2 || g[k] != g[1])) groupTris[g[k]].emplace_back(t);
+				const uint32 a = g[k], b = g[(k + 1) % 3];
+				if (a != b) edges.emplace_back(EdgeKey(a, b));
+			}
+		}
+
+		//1つの面にしか属さない辺は縁。その頂点は固定する
+		std::sort(edges.begin(), edges.end());
+		Array<uint8> locked(numgroups, 0);
+		Array<uint64> uniqueEdges;
+		for (size_t i = 0; i < edges.size(); )
+		{
+			size_t j = i + 1;
+			while (j < edges.size() && edges[j] == edges[i]) j++;
+			const uint32 a = (uint32)(edges[i] >> 32), b = (uint32)edges[i];
+			if (j - i == 1) locked[a] = locked[b] = 1;
+			uniqueEdges.emplace_back(edges[i]);
+			i = j;
+		}
+
+		Array<TriangleIndex32> work = tris;
+		Array<uint8> alive(tris.size(), 1);
+		Array<uint8> removed(numgroups, 0);
+		Array<uint32> version(numgroups, 0);
+		size_t numalive = tris.size();
+
+		//縮約候補(from を to へ寄せる)
+		struct Candidate
+		{
+			double cost;
+			uint32 from, to;
+			uint32 vfrom, vto;
+			bool operator > (const Candidate& c) const noexcept { return cost > c.cost; }
+		};
+		std::priority_queue<Candidate, std::vector<Candidate>, std::greater<Candidate>> heap;
+
+		auto push = [&](uint32 from, uint32 to)
+		{
+			if (locked[from] || removed[from] || removed[to]) return;
+			const Quadric q = quadric[from] + quadric[to];
+			heap.push(Candidate{ q.evaluate(position[to]), from, to, version[from], version[to] });
+		};
+
+		for (const uint64 e : uniqueEdges)
+		{
+			const uint32 a = (uint32)(e >> 32), b = (uint32)e;
+			push(a, b);
+			push(b, a);
+		}
+
+		auto corner = [&](uint32 t, uint32 k) -> uint32& { return (k == 0) ? work[t].i0 : (k == 1) ? work[t].i1 : work[t].i2; };
+
+		while (numalive > target && !heap.empty())
+		{
+			const Candidate c = heap.top();
+			heap.pop();
+			if (removed[c.from] || removed[c.to]) continue;
+			if (version[c.from] != c.vfrom || version[c.to] != c.vto) continue;
+
+			//寄せた後に裏返る面があれば見送る
+			bool flip = false;
+			for (const uint32 t : groupTris[c.from])
+			{
+				if (!alive[t]) continue;
+
+				Vec3 p[3], q[3];
+				bool shared = false;
+				for (uint32 k = 0; k < 3; k++)
+				{
+					const uint32 g = group[corner(t, k)];
+					if (g == c.to) shared = true;
+					p[k] = position[g];
+					q[k] = (g == c.from) ? position[c.to] : position[g];
+				}
+				if (shared) continue;
+
+				//向きが大きく変わる面も折れ目になりやすいので避ける
+				const Vec3 n0 = (p[1] - p[0]).cross(p[2] - p[0]);
+				const Vec3 n1 = (q[1] - q[0]).cross(q[2] - q[0]);
+				if (n0.dot(n0) == 0) continue;
+				if (n0.dot(n1) <= 0.25 * n0.length() * n1.length()) { flip = true; break; }
+			}
+			if (flip) continue;
+
+			//面を付け替える。to を共有する面は潰れるので消す
+			for (const uint32 t : groupTris[c.from])
+			{
+				if (!alive[t]) continue;
+
+				bool shared = false;
+				for (uint32 k = 0; k < 3; k++) shared |= (group[corner(t, k)] == c.to);
+				if (shared)
+				{
+					alive[t] = 0;
+					numalive--;
+					continue;
+				}
+
+				for (uint32 k = 0; k < 3; k++)
+				{
+					uint32& v = corner(t, k);
+					if (group[v] == c.from) v = nearestVertex(verts, groupVerts[c.to], verts[v]);
+				}
+				groupTris[c.to].emplace_back(t);
+			}
+
+			groupTris[c.from].clear();
+			quadric[c.to] += quadric[c.from];
+			removed[c.from] = 1;
+			version[c.to]++;
+
+			//to の周りの候補を作り直す
+			for (const uint32 t : groupTris[c.to])
+			{
+				if (!alive[t]) continue;
+				for (uint32 k = 0; k < 3; k++)
+				{
+					const uint32 g = group[corner(t, k)];
+					if (g == c.to) continue;
+					push(c.to, g);
+					push(g, c.to);
+				}
+			}
+		}
+
+		if (numalive == tris.size()) return{};
+
+		//使う頂点だけに詰める
+		PixieLOD lod;
+		lod.numSourceVertices = verts.size();
+		Array<uint32> remap(verts.size(), UINT32_MAX);
+		lod.indices.reserve(numalive);
+		for (uint32 t = 0; t < work.size(); t++)
+		{
+			if (!alive[t]) continue;
+
+			uint32 idx[3];
+			for (uint32 k = 0; k < 3; k++)
+			{
+				const uint32 v = corner(t, k);
+				if (remap[v] == UINT32_MAX)
+				{
+					remap[v] = (uint32)lod.vertices.size();
+					lod.vertices.emplace_back(v);
+				}
+				idx[k] = remap[v];
+			}
+			lod.indices.emplace_back(TriangleIndex32{ idx[0], idx[1], idx[2] });
+		}
+		return lod;
+	}
+
+private:
+	//対称4x4行列の上三角(a2 ab ac ad b2 bc bd c2 cd d2)
+	struct Quadric
+	{
+		double m[10] = {};
+
+		static Quadric FromPlane(double a, double b, double c, double d, double w)
+		{
+			Quadric q;
+			q.m[0] = w * a * a; q.m[1] = w * a * b; q.m[2] = w * a * c; q.m[3] = w * a * d;
+			q.m[4] = w * b * b; q.m[5] = w * b * c; q.m[6] = w * b * d;
+			q.m[7] = w * c * c; q.m[8] = w * c * d;
+			q.m[9] = w * d * d;
+			return q;
+		}
+
+		Quadric& operator += (const Quadric& q) noexcept
+		{
+			for (int32 i = 0; i < 10; i++) m[i] += q.m[i];
+			return *this;
+		}
+
+		Quadric operator + (const Quadric& q) const noexcept
+		{
+			Quadric r = *this;
+			return r += q;
+		}
+
+		double evaluate(const Vec3& v) const noexcept
+		{
+			return m[0] * v.x * v.x + 2 * m[1] * v.x * v.y + 2 * m[2] * v.x * v.z + 2 * m[3] * v.x
+				 + m[4] * v.y * v.y + 2 * m[5] * v.y * v.z + 2 * m[6] * v.y
+				 + m[7] * v.z * v.z + 2 * m[8] * v.z
+				 + m[9];
+		}
+	};
+
+	static uint64 EdgeKey(uint32 a, uint32 b) noexcept
+	{
+		return (a < b) ? ((uint64)a << 32 | b) : ((uint64)b << 32 | a);
+	}
+
+	//寄せ先の位置にある頂点のうち、法線とUVが最も近いもの
+	static uint32 nearestVertex(const Array<Vertex3D>& verts, const Array<uint32>& candidates, const Vertex3D& v)
+	{
+		uint32 best = candidates[0];
+		float bestd = FLT_MAX;
+		for (const uint32 c : candidates)
+		{
+			const float d = (1.0f - verts[c].normal.dot(v.normal)) + verts[c].tex.distanceFromSq(v.tex);
+			if (d < bestd)
+			{
+				bestd = d;
+				best = c;
+			}
+		}
+		return best;
+	}
+};
@@ -0,0 +1,270 @@
+﻿# pragma once
+
+# include <Siv3D.hpp>
+# include "PixieCamera.hpp"
+# include "PixieMesh.hpp"
+
+enum PARTICLEMODE { PM_MESH, PM_BILLBOARD };
+
+//パーティクル(SoA配置)。生存粒子は常に[0,count)に詰めて保持する
+class PixieParticles
+{
+private:
+	size_t		count = 0;
+	size_t		serial = 0;
+
+public:
+	static constexpr size_t npos = SIZE_MAX;
+
+	// 毎フレーム更新する要素
+	Array<float>		easing;					//イージング(大きさと色に適用)
+	Array<float>		speed;					//イージング速度
+	Array<Quaternion>	qRot;					//回転
+
+	// 生成時に決まる要素
+	Array<Quaternion>	qSpin;					//スピン
+	Array<Float3>		scale;					//大きさ
+	Array<ColorF>		color;					//色
+	Array<float>		offsetD;				//軌道の奥行位置
+	Array<float>		offsetH;				//軌道の幅
+	Array<uint32>		variant;				//生成順の通し番号(形状や軌道オフセットの選択用)
+
+	// シミュレーション結果(描画用、毎フレーム全生存粒子について再計算するため kill() では移動しない)
+	Array<double>		param;					//軌道パラメータ
+	Array<Float3>		pos;					//描画位置
+	Array<Float3>		tangent;				//軌道の進行方向
+	Array<float>		drawScale;				//描画スケール
+
+	PixieParticles() = default;
+	explicit PixieParticles(size_t capacity)
+	{
+		setCapacity(capacity);
+	}
+
+	//粒子の最大数を決めて各配列を確保する。spawn() はこの数を超えない(超える分はnpos)
+	void setCapacity(size_t capacity)
+	{
+		easing.resize(capacity);
+		speed.resize(capacity);
+		qRot.resize(capacity);
+		qSpin.resize(capacity);
+		scale.resize(capacity);
+		color.resize(capacity);
+		offsetD.resize(capacity);
+		offsetH.resize(capacity);
+		variant.resize(capacity);
+		param.resize(capacity);
+		pos.resize(capacity);
+		tangent.resize(capacity);
+		drawScale.resize(capacity);
+		if (count > capacity) count = capacity;
+	}
+
+	size_t size() const noexcept { return count; }
+	size_t capacity() const noexcept { return easing.size(); }
+	bool isFull() const noexcept { return count == capacity(); }
+
+	//末尾に追加してインデックスを返す O(1)。満杯ならnpos
+	size_t spawn()
+	{
+		if (isFull()) return npos;
+
+		const size_t i = count++;
+		easing[i] = 0.0f;
+		speed[i] = 0.0f;
+		qRot[i] = Quaternion::Identity();
+		qSpin[i] = Quaternion::Identity();
+		scale[i] = Float3{ 1,1,1 };
+		color[i] = ColorF{ 1 };
+		offsetD[i] = 0.0f;
+		offsetH[i] = 0.0f;
+		variant[i] = (uint32)(serial++);
+		return i;
+	}
+
+	//末尾の粒子で穴を埋めて削除 O(1)
+	void kill(size_t i)
+	{
+		const size_t last = --count;
+		if (i == last) return;
+
+		easing[i] = easing[last];
+		speed[i] = speed[last];
+		qRot[i] = qRot[last];
+		qSpin[i] = qSpin[last];
+		scale[i] = scale[last];
+		color[i] = color[last];
+		offsetD[i] = offsetD[last];
+		offsetH[i] = offsetH[last];
+		variant[i] = variant[last];
+	}
+
+	void clear() noexcept
+	{
+		count = 0;
+	}
+
+	//イージングを進め、寿命(easing>1)を超えた粒子を詰めて削除する
+	void advance()
+	{
+		size_t i = 0;
+		for (; i + 4 <= count; i += 4)
+		{
+			const DirectX::XMVECTOR e = DirectX::XMLoadFloat4((const DirectX::XMFLOAT4*)&easing[i]);
+			const DirectX::XMVECTOR s = DirectX::XMLoadFloat4((const DirectX::XMFLOAT4*)&speed[i]);
+			DirectX::XMStoreFloat4((DirectX::XMFLOAT4*)&easing[i], DirectX::XMVectorAdd(e, s));
+		}
+		for (; i < count; i++)
+			easing[i] += speed[i];
+
+		for (size_t i = 0; i < count; )
+		{
+			if (easing[i] > 1.0f) kill(i);
+			else i++;
+		}
+	}
+};
+
+//パーティクルのビルボード描画。グリフを1度だけアトラスに焼き、毎フレーム1つの頂点バッファに四角形を詰めて描く
+class PixieBillboard
+{
+private:
+	RenderTexture			atlas;
+	DynamicMesh				mesh;
+	Array<Vertex3D>			vertices;
+	Array<uint32>			order;						//描画順(色で並べ替え)
+	int32					numCells = 0;
+	float					cellExtent = 1.0f;			//セル1枚が覆うワールド空間の大きさ
+
+public:
+	//フレームループの前に呼ぶ(カメラ設定を書き換える)
+	void bakeAtlas(PixieMesh& font, Array<TextLayout>& layouts, size_t capacity, int32 cellsize = 128)
+	{
+		numCells = (int32)layouts.size();
+		if (numCells == 0) return;
+
+		//全グリフを収める範囲
+		Float3 vmin = { FLT_MAX, FLT_MAX, FLT_MAX };
+		Float3 vmax = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+		for (auto& layout : layouts)
+		{
+			font.updateTextLayout(layout);
+			for (const auto& code : layout.codes)
+			{
+				for (const auto& mv : font.getMeshData(code).vertices)
+				{
+					vmin = Float3{ Min(vmin.x, mv.pos.x), Min(vmin.y, mv.pos.y), Min(vmin.z, mv.pos.z) };
+					vmax = Float3{ Max(vmax.x, mv.pos.x), Max(vmax.y, mv.pos.y), Max(vmax.z, mv.pos.z) };
+				}
+			}
+		}
+		if (vmin.x > vmax.x) return;
+
+		//最も薄い軸の方向から撮影する
+		const Float3 size = vmax - vmin;
+		const Float3 center = vmin + size / 2;
+		Float3 axis{ 1,0,0 }, up{ 0,1,0 };
+		if (size.y <= size.x && size.y <= size.z) { axis = Float3{ 0,1,0 }; up = Float3{ 0,0,1 }; }
+		else if (size.z <= size.x && size.z <= size.y) axis = Float3{ 0,0,1 };
+
+		constexpr double FOV = 30_deg;
+		cellExtent = size.length();
+		const float distance = (float)(cellExtent / 2 / std::tan(FOV / 2));
+		const PixieCamera camera(Size{ cellsize, cellsize }, FOV, center - axis * distance, center, 0.01, up);
+
+		Array<MSRenderTexture> cells;
+		for (int32 k = 0; k < numCells; k++)
+		{
+			cells.emplace_back(Size{ cellsize, cellsize }, TextureFormat::R8G8B8A8_Unorm_SRGB, HasDepth::Yes);
+
+			const ScopedRenderTarget3D target{ cells[k].clear(ColorF{ 0, 0 }) };
+			const ScopedRenderStates3D rs{ RasterizerState::SolidCullNone };
+			Graphics3D::SetCameraTransform(camera.getViewProj(), camera.getEyePosition());
+			font.drawString(layouts[k], Mat4x4::Identity(), ColorF{ 1 });
+			Graphics3D::Flush();
+			cells[k].resolve();
+		}
+
+		atlas = RenderTexture{ Size{ cellsize * numCells, cellsize }, TextureFormat::R8G8B8A8_Unorm_SRGB };
+		{
+			const ScopedRenderTarget2D target{ atlas.clear(ColorF{ 0, 0 }) };
+			const ScopedRenderStates2D bs{ BlendState::Opaque };
+			for (int32 k = 0; k < numCells; k++) cells[k].draw(k * cellsize, 0);
+		}
+		Graphics2D::Flush();
+
+		//インデックスは容量分を一度だけ作る
+		vertices.resize(capacity * 4);
+		Array<TriangleIndex32> indices(capacity * 2);
+		for (uint32 i = 0; i < capacity; i++)
+		{
+			const uint32 v = i * 4;
+			indices[i * 2 + 0] = TriangleIndex32{ v + 0, v + 1, v + 2 };
+			indices[i * 2 + 1] = TriangleIndex32{ v + 2, v + 1, v + 3 };
+		}
+		mesh = DynamicMesh{ MeshData{ vertices, indices } };
+		vertices.clear();
+	}
+
+	//Vertex3D は頂点色を持たないので、同じ色の粒子を並べて色毎に drawSubset する(雪のように単色なら1回)
+	//粒子の回転(qRot、スピン込み)は視線軸まわりの回転(ロール)だけを四角形に反映する
+	void draw(const PixieParticles& particles, const PixieCamera& camera, const ColorF& color = ColorF{ 1 })
+	{
+		if (numCells == 0 || particles.size() == 0) return;
+
+		const size_t num = Min(particles.size(), particles.capacity());
+		vertices.resize(num * 4);
+
+		//色で並べ替えた描画順。全粒子が同じ色なら並べ替えない
+		order.resize(num);
+		for (uint32 i = 0; i < num; i++) order[i] = i;
+		bool single = true;
+		for (size_t i = 1; i < num && single; i++) single = (particles.color[i] == particles.color[0]);
+		if (!single)
+		{
+			std::stable_sort(order.begin(), order.end(), [&](uint32 a, uint32 b)
+				{ return particles.color[a].toColor().asUint32() < particles.color[b].toColor().asUint32(); });
+		}
+
+		const Mat4x4& invView = camera.getInvView();
+		const Float3 right{ DirectX::XMVectorGetX(invView.value.r[0]), DirectX::XMVectorGetY(invView.value.r[0]), DirectX::XMVectorGetZ(invView.value.r[0]) };
+		const Float3 up{ DirectX::XMVectorGetX(invView.value.r[1]), DirectX::XMVectorGetY(invView.value.r[1]), DirectX::XMVectorGetZ(invView.value.r[1]) };
+		const Float3 normal = -camera.getLookAtVector();
+		const float du = 1.0f / numCells;
+		for (size_t k = 0; k < num; k++)
+		{
+			const uint32 i = order[k];
+			const float s = particles.drawScale[i] * cellExtent;
+			const Mat4x4 m = camera.billboard(particles.pos[i], Float2{ s, s });
+			const float u0 = (particles.variant[i] % numCells) * du;
+
+			//粒子のX軸をスクリーン面に投影した角度がロール
+			const Float3 ax = particles.qRot[i] * Float3{ 1,0,0 };
+			float sn = ax.dot(up), cs = ax.dot(right);
+			const float len = std::sqrt(sn * sn + cs * cs);
+			if (len > 1e-6f) { sn /= len; cs /= len; }
+			else { sn = 0; cs = 1; }
+			const Float2 cx{ 0.5f * cs, 0.5f * sn };		//回転後の(+0.5, 0)
+			const Float2 cy{ -0.5f * sn, 0.5f * cs };		//回転後の(0, +0.5)
+
+			Vertex3D* v = &vertices[k * 4];
+			v[0] = Vertex3D{ m.transformPoint(Float3{ -cx + cy, 0 }), normal, Float2{ u0,      0 } };
+			v[1] = Vertex3D{ m.transformPoint(Float3{ +cx + cy, 0 }), normal, Float2{ u0 + du, 0 } };
+			v[2] = Vertex3D{ m.transformPoint(Float3{ -cx - cy, 0 }), normal, Float2{ u0,      1 } };
+			v[3] = Vertex3D{ m.transformPoint(Float3{ +cx - cy, 0 }), normal, Float2{ u0 + du, 1 } };
+		}
+
+		mesh.fill(vertices);
+
+		const ScopedRenderStates3D rs{ BlendState::OpaqueAlphaToCoverage, RasterizerState::SolidCullNone };
+		for (size_t begin = 0; begin < num; )
+		{
+			const ColorF& c = particles.color[order[begin]];
+			size_t end = begin + 1;
+			while (end < num && particles.color[order[end]] == c) end++;
+
+			mesh.drawSubset((uint32)(begin * 2), (uint32)((end - begin) * 2), Mat4x4::Identity(), atlas, color * c);
+			begin = end;
+		}
+	}
+};
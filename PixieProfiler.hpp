@@ -0,0 +1,226 @@
+﻿# pragma once
+
+# include <algorithm>
+# include <atomic>
+# include <chrono>
+# include <cmath>
+# include <memory>
+# include <mutex>
+# include <numeric>
+# include <string_view>
+# include <Siv3D.hpp>
+
+//区間計測のCPUプロファイラ
+//PIXIE_PROFILE(名前) を置いたスコープの時間をスレッド毎に記録し、NextFrame() でフレーム毎の合計にまとめて最小/平均/99パーセンタイルを出す
+//直近のフレームはChromeのトレース形式(chrome://tracing, Perfetto)で書き出せる
+//無効の間はスコープ毎にフラグを1度読むだけ。PIXIE_NO_PROFILER を定義すると何も展開しない
+struct PixieProfiler
+{
+	struct Event
+	{
+		const char*	name = nullptr;		//文字列リテラル(ポインタのまま持つ)
+		uint64		begin = 0;			//ns
+		uint64		end = 0;
+		uint32		thread = 0;
+	};
+
+	//フレーム毎の合計(ms)の統計。そのスコープを通ったフレームだけで数える
+	struct Stat
+	{
+		String	name;
+		double	last = 0;
+		double	min = 0;
+		double	avg = 0;
+		double	p99 = 0;
+		size_t	frames = 0;
+	};
+
+	static uint64 Now() noexcept
+	{
+		return (uint64)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+private:
+	struct ThreadBuffer
+	{
+		std::mutex		mutex;
+		Array<Event>	events;
+		uint32			thread = 0;
+	};
+
+	struct History
+	{
+		Array<double>	samples;		//フレーム毎の合計(ms)。window個で回す
+		size_t			next = 0;
+		double			total = 0;		//集計中のフレームの合計
+		double			last = 0;
+		bool			hit = false;
+	};
+
+	static inline std::atomic<bool>					enabled{ false };
+	static inline std::mutex						mutex;
+	static inline Array<std::unique_ptr<ThreadBuffer>>	buffers;
+	static inline HashTable<std::string_view, History>	histories;
+	static inline Array<Array<Event>>				traceFrames;		//直近のフレームのイベント。traceNext から古い順
+	static inline size_t							traceNext = 0;
+	static inline size_t							window = 300;
+	static inline uint64							origin = Now();
+
+	static ThreadBuffer& local()
+	{
+		thread_local ThreadBuffer* buffer = nullptr;
+		if (buffer == nullptr)
+		{
+			std::lock_guard lock{ mutex };
+			auto& b = buffers.emplace_back(std::make_unique<ThreadBuffer>());
+			b->thread = (uint32)(buffers.size() - 1);
+			buffer = b.get();
+		}
+		return *buffer;
+	}
+
+public:
+	static bool IsEnabled() noexcept
+	{
+		return enabled.load(std::memory_order_relaxed);
+	}
+
+	//windowは統計とトレースに残すフレーム数
+	static void SetEnabled(bool enable, size_t frames = 300)
+	{
+		std::lock_guard lock{ mutex };
+		if (enable && !enabled.load(std::memory_order_relaxed))
+		{
+			window = Max<size_t>(frames, 1);
+			histories.clear();
+			traceFrames.clear();
+			traceNext = 0;
+		}
+		enabled.store(enable, std::memory_order_relaxed);
+	}
+
+	static void Record(const char* name, uint64 begin, uint64 end)
+	{
+		ThreadBuffer& b = local();
+		std::lock_guard lock{ b.mutex };
+		b.events.emplace_back(Event{ name, begin, end, b.thread });
+	}
+
+	//フレームの区切りで呼ぶ(ジョブやOpenMPの並列区間の外で)。各スレッドの記録を集めて直前フレームの合計を確定する
+	static void NextFrame()
+	{
+		std::lock_guard lock{ mutex };
+
+		Array<Event> frame;
+		for (auto& b : buffers)
+		{
+			std::lock_guard blk{ b->mutex };
+			frame.append(b->events);
+			b->events.clear();
+		}
+		if (!enabled.load(std::memory_order_relaxed)) return;
+
+		for (const Event& e : frame)
+		{
+			History& h = histories[e.name];
+			h.total += (e.end - e.begin) / 1e6;
+			h.hit = true;
+		}
+
+		for (auto& [name, h] : histories)
+		{
+			if (!h.hit) continue;
+
+			if (h.samples.size() < window) h.samples.emplace_back(h.total);
+			else h.samples[h.next] = h.total;
+			h.next = (h.next + 1) % window;
+			h.last = h.total;
+			h.total = 0;
+			h.hit = false;
+		}
+
+		if (frame.isEmpty()) return;
+		if (traceFrames.size() < window) traceFrames.emplace_back(std::move(frame));
+		else traceFrames[traceNext] = std::move(frame);
+		traceNext = (traceNext + 1) % window;
+	}
+
+	//名前順の統計
+	static Array<Stat> GetStats()
+	{
+		std::lock_guard lock{ mutex };
+
+		Array<Stat> stats;
+		for (const auto& [name, h] : histories)
+		{
+			if (h.samples.isEmpty()) continue;
+
+			Array<double> sorted = h.samples;
+			std::sort(sorted.begin(), sorted.end());
+
+			Stat s;
+			s.name = Unicode::FromUTF8(name);
+			s.last = h.last;
+			s.min = sorted.front();
+			s.avg = std::accumulate(sorted.begin(), sorted.end(), 0.0) / sorted.size();
+			s.p99 = sorted[Min(sorted.size() - 1, (size_t)std::ceil(sorted.size() * 0.99) - 1)];
+			s.frames = sorted.size();
+			stats.emplace_back(std::move(s));
+		}
+		std::sort(stats.begin(), stats.end(), [](const Stat& a, const Stat& b) { return a.name < b.name; });
+		return stats;
+	}
+
+	//直近windowフレームをChromeのトレース形式(完了イベント "ph":"X")で書き出す
+	static bool ExportChromeTrace(FilePathView path)
+	{
+		std::lock_guard lock{ mutex };
+
+		TextWriter writer{ path };
+		if (!writer) return false;
+
+		writer.writeln(U"{\"traceEvents\":[");
+		bool first = true;
+		for (size_t f = 0; f < traceFrames.size(); f++)
+		{
+			const size_t idx = (traceFrames.size() < window) ? f : (traceNext + f) % window;
+			for (const Event& e : traceFrames[idx])
+			{
+				writer.writeln(U"{}{{\"name\":\"{}\",\"cat\":\"cpu\",\"ph\":\"X\",\"ts\":{:.3f},\"dur\":{:.3f},\"pid\":0,\"tid\":{}}}"_fmt(
+					first ? U"" : U",", Unicode::FromUTF8(e.name), (e.begin - origin) / 1e3, (e.end - e.begin) / 1e3, e.thread));
+				first = false;
+			}
+		}
+		writer.writeln(U"],\"displayTimeUnit\":\"ms\"}");
+		return true;
+	}
+};
+
+//スコープの開始から終わりまでを記録する。開始時に無効なら何もしない
+class PixieProfileScope
+{
+private:
+	const char*	m_name;
+	uint64		m_begin;
+
+public:
+	explicit PixieProfileScope(const char* name) noexcept
+		: m_name(PixieProfiler::IsEnabled() ? name : nullptr), m_begin(m_name ? PixieProfiler::Now() : 0) {}
+
+	~PixieProfileScope()
+	{
+		if (m_name) PixieProfiler::Record(m_name, m_begin, PixieProfiler::Now());
+	}
+
+	PixieProfileScope(const PixieProfileScope&) = delete;
+	PixieProfileScope& operator =(const PixieProfileScope&) = delete;
+};
+
+# define PIXIE_PROFILE_CONCAT_(a, b) a##b
+# define PIXIE_PROFILE_CONCAT(a, b) PIXIE_PROFILE_CONCAT_(a, b)
+
+# if defined(PIXIE_NO_PROFILER)
+#	define PIXIE_PROFILE(name)
+# else
+#	define PIXIE_PROFILE(name) const PixieProfileScope PIXIE_PROFILE_CONCAT(pixieProfileScope_, __LINE__){ name }
+# endif
@@ -0,0 +1,122 @@
+﻿# pragma once
+
+# include <Siv3D.hpp>
+# include "PixieMesh.hpp"
+
+//固定刻みのシミュレーションと可変レートの描画
+//描画フレーム毎に経過時間を積み、刻み幅に達した分だけティックを進める。端数は getAlpha() で描画の補間に使う
+class PixieScheduler
+{
+private:
+	double		m_step = 1.0 / 60;
+	double		m_accumulator = 0;
+	double		m_maxDelta = 0.25;			//これ以上の経過時間は捨てる(ブレークポイントや読み込みでの停止)
+	int32		m_maxSteps = 8;				//1描画フレームで進める上限(追いつけない時に描画が止まらないように)
+	uint64		m_tick = 0;
+
+public:
+	PixieScheduler() = default;
+	explicit PixieScheduler(double hz, int32 maxSteps = 8)
+		: m_step(1.0 / hz), m_maxSteps(maxSteps) {}
+
+	//経過時間を積み、今回進めるティック数を返す
+	int32 advance(double deltaTime)
+	{
+		m_accumulator += Clamp(deltaTime, 0.0, m_maxDelta);
+
+		int32 steps = 0;
+		while (m_accumulator >= m_step && steps < m_maxSteps)
+		{
+			m_accumulator -= m_step;
+			steps++;
+		}
+
+		//上限で打ち切った分の遅れは持ち越さない
+		if (m_accumulator >= m_step) m_accumulator = std::fmod(m_accumulator, m_step);
+
+		m_tick += steps;
+		return steps;
+	}
+
+	//f(tick) を今回のティック数だけ呼ぶ
+	template <class Fty>
+	int32 update(double deltaTime, Fty f)
+	{
+		const int32 steps = advance(deltaTime);
+		for (int32 i = 0; i < steps; i++) f(m_tick - steps + i);
+		return steps;
+	}
+
+	//直前のティックから次のティックまでの割合[0,1)
+	double getAlpha() const noexcept { return m_accumulator / m_step; }
+
+	double getStepTime() const noexcept { return m_step; }
+	uint64 getTickCount() const noexcept { return m_tick; }
+
+	void reset() noexcept
+	{
+		m_accumulator = 0;
+		m_tick = 0;
+	}
+};
+
+//ティック間のメッシュ姿勢の補間
+//beginTick() で前回の姿勢に戻して退避し、endTick() で新しい姿勢を記録、interpolate() で描画用の中間姿勢を書き込む
+class PixieTransformHistory
+{
+private:
+	struct State
+	{
+		Float3		pos{ 0,0,0 };
+		Float3		rpos{ 0,0,0 };
+		Quaternion	qrot = Quaternion::Identity();
+	};
+
+	Array<PixieMesh*>	meshes;
+	Array<State>		prev;
+	Array<State>		curr;
+
+	static State capture(const PixieMesh& mesh)
+	{
+		return State{ mesh.Pos, mesh.rPos, mesh.qRot };
+	}
+
+	static void store(PixieMesh& mesh, const State& s)
+	{
+		mesh.setMove(s.pos).setMoveRelative(s.rpos).setRotateQ(s.qrot);
+	}
+
+public:
+	PixieTransformHistory& add(PixieMesh& mesh)
+	{
+		meshes.emplace_back(&mesh);
+		prev.emplace_back(capture(mesh));
+		curr.emplace_back(capture(mesh));
+		return *this;
+	}
+
+	void beginTick()
+	{
+		for (size_t i = 0; i < meshes.size(); i++)
+		{
+			store(*meshes[i], curr[i]);
+			prev[i] = curr[i];
+		}
+	}
+
+	void endTick()
+	{
+		for (size_t i = 0; i < meshes.size(); i++) curr[i] = capture(*meshes[i]);
+	}
+
+	void interpolate(double alpha)
+	{
+		const float t = (float)alpha;
+		for (size_t i = 0; i < meshes.size(); i++)
+		{
+			const State& a = prev[i];
+			const State& b = curr[i];
+			store(*meshes[i], State{ a.pos.lerp(b.pos, t), a.rpos.lerp(b.rpos, t), a.qrot.slerp(b.qrot, t) });
+		}
+	}
+};
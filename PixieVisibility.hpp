@@ -0,0 +1,131 @@
+﻿# pragma once
+
+# include <Siv3D.hpp>
+# include "PixieCamera.hpp"
+# include "PixieMesh.hpp"
+
+//複数カメラで共有する可視判定
+//ワールド行列とOBBはPixieMeshのキャッシュを読むだけにし、全ビューの視錐台でまとめて判定してビュー毎の描画リストを作る
+class PixieVisibility
+{
+public:
+	static constexpr size_t MAXVIEWS = 32;			//可視マスクのビット数
+
+	struct Entry
+	{
+		PixieMesh*	mesh = nullptr;
+		int32		anime = NOTUSE;					//NOTUSEならdrawMesh、それ以外はdrawAnimeのアニメ番号
+		uint32		viewMask = ~0u;					//描くビュー(ビットiがビューi)
+		uint32		visibleMask = 0;				//判定結果
+	};
+
+private:
+	Array<Entry>				entries;
+	Array<const PixieCamera*>	views;
+	Array<Array<uint32>>		drawLists;
+	const PixieFrustum*			frustums[MAXVIEWS] = {};
+
+public:
+	//ビューとオブジェクトはフレームループの前に1度だけ登録する(参照先は登録中ずっと有効であること)
+	int32 addView(const PixieCamera& camera)
+	{
+		assert(views.size() < MAXVIEWS);
+		views.emplace_back(&camera);
+		drawLists.resize(views.size());
+		return (int32)views.size() - 1;
+	}
+
+	PixieVisibility& add(PixieMesh& mesh, int32 anime = NOTUSE, uint32 viewMask = ~0u)
+	{
+		Entry& e = entries.emplace_back();
+		e.mesh = &mesh;
+		e.anime = anime;
+		e.viewMask = viewMask;
+		for (auto& list : drawLists) list.reserve(entries.size());
+		return *this;
+	}
+
+	void clear()
+	{
+		entries.clear();
+		views.clear();
+		drawLists.clear();
+	}
+
+	size_t num_views() const noexcept { return views.size(); }
+	const Array<Entry>& getEntries() const noexcept { return entries; }
+	const Array<uint32>& getDrawList(int32 view) const { return drawLists[view]; }
+
+	//制御の後、描画の前に呼ぶ。アニメはこの時点の現在フレームの範囲で判定するので、全ビューを描き終えるまで nextFrame しない
+	void update()
+	{
+		beginUpdate();
+		cull(0, entries.size());
+		endUpdate();
+	}
+
+	//update() を分けたもの。cull() はエントリの範囲を分けて並列に呼べる(同じメッシュを2度登録しないこと)
+	void beginUpdate()
+	{
+		//視錐台は遅延計算なのでここで確定させておく
+		for (size_t v = 0; v < views.size(); v++)
+		{
+			frustums[v] = &views[v]->getFrustum();
+			drawLists[v].clear();
+		}
+	}
+
+	void cull(size_t begin, size_t end)
+	{
+		PIXIE_PROFILE("PixieVisibility::cull");
+		const size_t numviews = views.size();
+		for (size_t i = begin; i < end; i++)
+		{
+			Entry& e = entries[i];
+			PixieMesh& mesh = *e.mesh;
+
+			e.visibleMask = 0;
+			if (mesh.Pos.hasNaN() || mesh.qRot.hasNaN() || mesh.qRot.hasInf()) continue;
+
+			const OrientedBox& ob = mesh.ob = mesh.getWorldOBB(e.anime);
+
+			for (size_t v = 0; v < numviews; v++)
+			{
+				if ((e.viewMask & (1u << v)) && frustums[v]->intersects(ob)) e.visibleMask |= (1u << v);
+			}
+		}
+	}
+
+	//判定結果からビュー毎の描画リストを作る
+	void endUpdate()
+	{
+		const size_t numviews = views.size();
+		for (uint32 i = 0; i < entries.size(); i++)
+		{
+			const Entry& e = entries[i];
+			for (size_t v = 0; v < numviews; v++)
+			{
+				if (!(e.viewMask & (1u << v))) continue;
+
+				if (e.visibleMask & (1u << v)) drawLists[v].emplace_back(i);
+				else PixieMesh::culledCount++;
+			}
+		}
+	}
+
+	//ビューの描画リストを描く。プリミティブ単位の判定とLODの選択はそのビューのカメラで行う
+	void draw(int32 view, ColorF usrColor = ColorF(NOTUSE))
+	{
+		PixieMesh::setCullFrustum(&views[view]->getFrustum());
+		PixieMesh::setLODCamera(views[view]);
+		for (const uint32 i : drawLists[view])
+		{
+			PixieMesh& mesh = *entries[i].mesh;
+			const int32 anime = entries[i].anime;
+			if (anime == NOTUSE) mesh.drawMeshWorld(mesh.getWorldMatrix(), mesh.getWorldRotation(), usrColor);
+			else				 mesh.drawAnimeWorld(mesh.getWorldMatrix(), mesh.getWorldRotation(), anime, NOTUSE, usrColor);
+		}
+		PixieMesh::setCullFrustum(nullptr);
+		PixieMesh::setLODCamera(nullptr);
+	}
+};
@@ -0,0 +1,405 @@
+﻿# pragma once
+
+# include <Siv3D.hpp> // OpenSiv3D v0.6.3
+
+# include "PixieMesh.hpp"
+# include "PixieCamera.hpp"
+# include "LineString3D.hpp"
+# include "PixieParticle.hpp"
+# include "PixieVisibility.hpp"
+# include "PixieScheduler.hpp"
+# include "PixieJobs.hpp"
+# include "PixieProfiler.hpp"
+
+//XMasのシーン(メッシュ、軌道、制御)。Main.cpp の描画ループと Benchmark.cpp のヘッドレス計測で共有する
+
+constexpr Size			WINDOWSIZE = { 1280, 768 };
+
+# if defined(_WIN32)
+constexpr StringView	APATH = U"../Asset/";   // WINDOWS(App フォルダから実行)
+# else
+constexpr StringView	APATH = U"./Asset/";    // LINUX(リポジトリのルートから実行)
+# endif
+
+constexpr ColorF        WHITE = ColorF{ 1,1,1,USE_COLOR };
+constexpr Vec2			TREECENTER{ -100, -100 };
+constexpr double		TREERASIUS = 100;
+constexpr double		VOLALITY = 40;
+constexpr double		TONAKAISPEED = 0.00008;	//1ティックあたりの進行度
+constexpr double		SIMULATIONHZ = 60;			//シミュレーションの刻み(描画は可変)
+constexpr int32			NUMSNOW = 7 * 100;
+constexpr size_t		SNOWGRAIN = 256;			//雪の更新ジョブ1つあたりの粒子数(4の倍数)
+
+struct ActorRecord
+{
+	ColorF Color = WHITE;
+	Float3 Pos = Float3{ 0,0,0 };
+	Float3 Sca = Float3{ 1,1,1 };
+	Float3 rPos = Float3{ 0,0,0 };
+	Float3 eRot = Float3{ 0,0,0 };
+	Quaternion qRot = Quaternion::Identity();
+	Float3 eyePos = Float3{ 0,0,0 };
+	Float3 focusPos = Float3{ 0,0,0 };
+};
+
+enum SELECTEDTARGET
+{
+	ST_SLED, ST_FONT, ST_CAMERA, ST_TREE, ST_GND,
+	ST_TONAKI_A,
+	ST_TONAKI_B, ST_TONAKI_C, ST_TONAKI_D,
+	ST_TONAKI_E, ST_TONAKI_F, ST_TONAKI_G,
+	NUMST
+};
+
+inline Array<ActorRecord> actorRecords;
+
+inline PixieParticles snowParticles(NUMSNOW);
+inline PixieBillboard snowBillboard;
+inline PARTICLEMODE snowMode = PM_MESH;
+inline Array<TextLayout> snowLayouts = { TextLayout{ U"\xBF", 0 }, TextLayout{ U"\xC0", 0 }, TextLayout{ U"\xC1", 0 },
+										 TextLayout{ U"\xC2", 0 }, TextLayout{ U"\xC3", 0 }, TextLayout{ U"\xC4", 0 } };
+
+inline Array<PixieMesh> pixieMeshes(NUMST);
+inline PixieCamera cameraMain(WINDOWSIZE);
+inline DefaultRNG sceneRNG;			//シーンの乱数(軌道と雪)。ジョブのスレッドに依らず種で再現できるように
+
+inline void registerSnowFrake()
+{
+	const size_t i = snowParticles.spawn();
+	if (i == PixieParticles::npos) return;
+
+	snowParticles.offsetD[i] = 0.01f;
+	snowParticles.offsetH[i] = (float)(2 * (Random(-1.0, +1.0, sceneRNG)));
+	snowParticles.color[i] = WHITE;
+	snowParticles.scale[i] = Float3{ Random(0.1, 0.4, sceneRNG), 1, Random(0.1, 0.4, sceneRNG) };
+	snowParticles.qRot[i] = Quaternion::RollPitchYaw(Random(sceneRNG) * Math::TauF, Random(sceneRNG) * Math::TauF, Random(sceneRNG) * Math::TauF);
+	snowParticles.qSpin[i] = Quaternion::RollPitchYaw(Random(sceneRNG) * 0.314, Random(sceneRNG) * 0.314, Random(sceneRNG) * 0.314);
+	snowParticles.easing[i] = 0.0f;
+	snowParticles.speed[i] = (float)Random(0.003, 0.006, sceneRNG);
+}
+
+template <typename I> inline double combineEase(I easeA, I easeB, double e, double separator)
+{
+	return (e < separator) ? std::invoke(easeA, e / separator) :
+		1 - std::invoke(easeB, (e - separator) / (1 - separator));
+}
+
+//雪の結晶の生成と寿命(ティック毎に1度、チャンクの更新より先に)
+inline void spawnSnowFrake(LineString3D& ls3)
+{
+	PIXIE_PROFILE("XMasScene::spawnSnowFrake");
+	for (int32 i = 0; i < 4; i++) registerSnowFrake();
+
+	snowParticles.advance();
+	ls3.updateDistance();		//キャッシュ構築を先に済ませる
+}
+
+//雪の結晶軌道(シミュレーションのみ、描画はdrawSnowFrake)。[begin,end)は粒子の範囲で、生存数を超えた分は何もしない
+//begin は4の倍数(SNOWGRAIN 単位)なので、4粒子単位のSIMD処理をそのまま書ける
+inline void updateSnowFrake(const LineString3D& ls3, const double progressPos, size_t begin, size_t end)
+{
+	PixieParticles& snow = snowParticles;
+	end = Min(end, snow.size());
+	if (end <= begin) return;
+
+	PIXIE_PROFILE("XMasScene::updateSnowFrake");
+	const float BASE[7] = { 0, 0.001f,0.001f, 0.002f,0.002f, 0.003f,0.003f };
+
+	//イージング(4粒子単位のSIMD)
+	{
+		using namespace DirectX;
+		const XMVECTOR HALFPI = XMVectorReplicate(Math::HalfPiF);
+		const XMVECTOR ONE = XMVectorReplicate(1.0f);
+		const XMVECTOR SEPARATOR = XMVectorReplicate(0.8f);
+
+		size_t i = begin;
+		for (; i + 4 <= end; i += 4)
+		{
+			const XMVECTOR e = XMLoadFloat4((const XMFLOAT4*)&snow.easing[i]);
+
+			//EaseInSine(t) = 1 - cos(t*π/2)
+			const XMVECTOR ein = XMVectorSubtract(ONE, XMVectorCos(XMVectorMultiply(e, HALFPI)));
+			const XMVECTOR ea = XMVectorSubtract(ONE, XMVectorCos(XMVectorMultiply(XMVectorDivide(e, SEPARATOR), HALFPI)));
+			const XMVECTOR eb = XMVectorCos(XMVectorMultiply(XMVectorDivide(XMVectorSubtract(e, SEPARATOR), XMVectorSubtract(ONE, SEPARATOR)), HALFPI));
+			XMStoreFloat4((XMFLOAT4*)&snow.drawScale[i], XMVectorSelect(eb, ea, XMVectorLess(e, SEPARATOR)));
+
+			XMFLOAT4 lane;
+			XMStoreFloat4(&lane, XMVectorMultiply(ein, XMLoadFloat4((const XMFLOAT4*)&snow.offsetD[i])));
+			const float offset[4] = { lane.x, lane.y, lane.z, lane.w };
+			for (size_t ii = 0; ii < 4; ii++)
+			{
+				snow.param[i + ii] = progressPos + BASE[snow.variant[i + ii] % 7] - offset[ii];
+			}
+		}
+		for (; i < end; i++)
+		{
+			snow.drawScale[i] = (float)combineEase(EaseInSine, EaseInSine, snow.easing[i], 0.8);
+			snow.param[i] = progressPos + BASE[snow.variant[i] % 7] - snow.offsetD[i] * EaseInSine(snow.easing[i]);
+		}
+	}
+
+	//軌道上の位置と回転、幅
+	const size_t num = end - begin;
+	ls3.getPointsAtProgress({ &snow.param[begin], num }, { &snow.pos[begin], num }, { &snow.tangent[begin], num });
+	for (size_t i = begin; i < end; i++)
+	{
+		snow.qRot[i] *= snow.qSpin[i];											//結晶の回転
+
+		Float3 right = snow.tangent[i].cross(Float3{ 0,1,0 });				//水平な右ベクトル
+		if (right.lengthSq() > 0) right.normalize();
+		snow.pos[i] += right * snow.offsetH[i];								//右ベクトルから幅に適用
+	}
+}
+
+inline void drawSnowFrake(PixieMesh& mesh, const PixieCamera& camera)
+{
+	const PixieParticles& snow = snowParticles;
+	if (snowMode == PM_BILLBOARD)
+	{
+		snowBillboard.draw(snow, camera);
+		return;
+	}
+
+	for (size_t i = 0; i < snow.size(); i++)
+	{
+		const float v = snow.drawScale[i];
+		mesh.setRotateQ(snow.qRot[i]).setMove(snow.pos[i]).setScale(Float3{ v,v,v });
+		mesh.drawString(snowLayouts[snow.variant[i] % 6], snow.color[i]);
+	}
+}
+
+//トナカイ(i頭目)
+inline void updateTonakai(PixieMesh& mesh, const LineString3D& ls3, const double progressPos, const uint32 i)
+{
+	PIXIE_PROFILE("XMasScene::updateTonakai");
+	const double offset[7] = { 0, 0.001,0.001, 0.002,0.002, 0.003,0.003 };
+
+	const CurveFrame3D frame = ls3.getFrameAt(progressPos + offset[i]);
+	mesh.setMove(frame.position).setRotateQ(frame.orientation);
+	if (i == 1 || i == 3 || i == 5) mesh.setMoveRelative(-frame.right);
+	if (i == 2 || i == 4 || i == 6) mesh.setMoveRelative(+frame.right);
+}
+
+inline void updateTonakai(Array<PixieMesh>& meshes, const LineString3D& ls3, const double progressPos)
+{
+	for (uint32 i = 0; i < 7; i++) updateTonakai(meshes[ST_TONAKI_A + i], ls3, progressPos, i);
+}
+
+//ソリ
+inline void updateSled(PixieMesh& mesh, const LineString3D& ls3, const double progressPos)
+{
+	PIXIE_PROFILE("XMasScene::updateSled");
+	const CurveFrame3D frame = ls3.getFrameAt(progressPos - 0.004);
+	mesh.setMove(frame.position).setRotateQ(frame.orientation);
+}
+
+//トナカイカメラの操作。キー入力はエンジンから読むのでメインスレッドで取ってジョブに渡す
+struct CameraInput
+{
+	float	speed = 0.01f;
+	bool	left = false, right = false, up = false, down = false;
+};
+
+inline CameraInput sampleCameraInput()
+{
+	CameraInput input;
+	if (KeyRControl.pressed()) input.speed *= 5;
+	input.left = KeyLeft.pressed();
+	input.right = KeyRight.pressed();
+	input.up = KeyUp.pressed();
+	input.down = KeyDown.pressed();
+	return input;
+}
+
+//トナカイカメラ
+inline void updateCamera(PixieMesh& tonakai, PixieMesh& camera, const CameraInput& input)
+{
+	PIXIE_PROFILE("XMasScene::updateCamera");
+	tonakai.camera.setFocusPosition(tonakai.Pos);
+
+	const float speed = input.speed;
+	if (input.left)	 tonakai.camera.setEyePosition(tonakai.Pos + camera.camera.arcX(-speed).getEyePosition());
+	if (input.right) tonakai.camera.setEyePosition(tonakai.Pos + camera.camera.arcX(+speed).getEyePosition());
+	if (input.up)	 tonakai.camera.setEyePosition(tonakai.Pos + camera.camera.arcY(-speed).getEyePosition());
+	if (input.down)	 tonakai.camera.setEyePosition(tonakai.Pos + camera.camera.arcY(+speed).getEyePosition());
+	camera.setMove(tonakai.camera.getEyePosition());
+	camera.setRotateQ(tonakai.camera.getQForward());
+}
+
+enum XMASVIEW
+{
+	VIEWMAIN, VIEWPIP
+};
+
+//読み込みから1ティックの更新、可視判定、描画までの手順
+//ジョブグラフが this を参照するので、setup() の後は動かさないこと
+class XMasScene
+{
+public:
+	LineString3D			lineString3D;
+	double					progressPos = 0;	//現在位置をスタート位置に設定
+
+	PixieVisibility			visibility;
+	PixieScheduler			scheduler{ SIMULATIONHZ };
+	PixieTransformHistory	history;
+	PixieJobGraph			tickGraph;
+	PixieJobGraph			visibilityGraph;
+	CameraInput				cameraInput;		//update() の度にメインスレッドで取る
+
+	//メッシュの読み込みと焼き込み、LOD
+	void load(StringView assetPath)
+	{
+		//メッシュ設定
+		PixieMesh& meshSled = pixieMeshes[ST_SLED] = PixieMesh{ assetPath + U"XMas.Sled.006.glb", Float3{0, 0, 0} };
+		PixieMesh& meshFont = pixieMeshes[ST_FONT] = PixieMesh{ assetPath + U"ToD4Font.005.glb",  Float3{0, 0, 0} };
+		PixieMesh& meshCamera = pixieMeshes[ST_CAMERA] = PixieMesh{ assetPath + U"Camera.glb",    Float3{-50, 50, -50} };
+		PixieMesh& meshTree = pixieMeshes[ST_TREE] = PixieMesh{ assetPath + U"XMas.Tree.glb",     Float3{-100, 0, -100} };
+		PixieMesh& meshGND = pixieMeshes[ST_GND] = PixieMesh{ assetPath + U"XMas.GND.glb",        Float3{0, 0, 0} };
+
+		for (int32 i = 0; i < 7; i++)
+			pixieMeshes[ST_TONAKI_A + i] = PixieMesh{ assetPath + U"XMas.Tonakai.006.glb", Float3{1, 0, 0} };
+
+		//メッシュ初期化
+		meshSled.initModel(MODELANI, WINDOWSIZE, NOTUSE_STRING, USE_MORPH, nullptr, HIDDEN_BOUNDBOX, 60, 0);
+		meshFont.initModel(MODELNOA, WINDOWSIZE, USE_STRING, USE_MORPH);
+		meshTree.initModel(MODELNOA, WINDOWSIZE, USE_STRING, USE_MORPH);
+		meshCamera.initModel(MODELNOA, WINDOWSIZE);
+		meshGND.initModel(MODELNOA, WINDOWSIZE);
+
+		for (int32 i = 0; i < 7; i++)
+			pixieMeshes[ST_TONAKI_A + i].initModel(MODELANI, WINDOWSIZE, NOTUSE_STRING, USE_MORPH, nullptr, HIDDEN_BOUNDBOX, 30, 0);
+
+		//LOD(遠くのトナカイとPiPのツリー向け)
+		meshTree.generateLOD();
+		meshSled.generateLOD();
+		for (int32 i = 0; i < 7; i++) pixieMeshes[ST_TONAKI_A + i].generateLOD();
+
+		snowBillboard.bakeAtlas(meshFont, snowLayouts, NUMSNOW);
+	}
+
+	//カメラ、軌道、可視判定、ジョブグラフ。seedが同じなら軌道と雪は毎回同じになる
+	void setup(uint64 seed)
+	{
+		sceneRNG.seed(seed);
+
+		PixieMesh& meshSled = pixieMeshes[ST_SLED];
+		PixieMesh& meshCamera = pixieMeshes[ST_CAMERA];
+		PixieMesh& meshTree = pixieMeshes[ST_TREE];
+		PixieMesh& meshGND = pixieMeshes[ST_GND];
+		PixieMesh& meshTonakai = pixieMeshes[ST_TONAKI_A];
+
+		//カメラ初期化
+		Float4 eyePosMain = { 0, 1, 30.001, 0 };		//視点 XYZは座標、Wはカメラロールをオイラー角で保持
+		Float3 focusPosMain = { 0,  0, 0 };
+		cameraMain = PixieCamera(WINDOWSIZE, 45_deg, eyePosMain.xyz(), focusPosMain, 0.05);
+
+		meshTonakai.camera = PixieCamera(WINDOWSIZE, 45_deg, meshTonakai.Pos, meshTonakai.Pos + Float3{ 0,10,0 }, 0.05);
+		//	meshCamera.camera  = PixieCamera(WINDOWSIZE, 45_deg, meshCamera.Pos, meshSled.Pos + Float3{ 0,0,0 }, 0.05);
+
+		// 軌道計算
+		ActorRecord val;
+		actorRecords.clear();
+		for (int32 yy = 0; yy < 4; yy++)
+		{
+			for (int32 r = 0; r < 18; r++)
+			{
+				const Vec2 pos2 = TREECENTER + Circular(TREERASIUS, ToRadians(r * 20));
+				val.Pos = Float3{ pos2.x + VOLALITY * (Random(sceneRNG) - 0.5),
+								  30 * yy + VOLALITY * Random(sceneRNG),
+								  pos2.y + VOLALITY * (Random(sceneRNG) - 0.5) };
+				actorRecords.emplace_back(val);
+			}
+		}
+
+		lineString3D.clear();
+		for (uint32 i = 1; i < actorRecords.size(); i++)
+			lineString3D.emplace_back(actorRecords[i].Pos + actorRecords[i].rPos);
+		lineString3D.setClosed(true);		//周回軌道(進行度は一周で巻き戻る)
+
+		progressPos = 0;
+
+		//可視判定(メインとPiPで共有)。ツリーとカメラはメインのみ
+		visibility.clear();
+		visibility.addView(cameraMain);
+		visibility.addView(meshCamera.camera);
+		const uint32 MASKMAIN = 1u << VIEWMAIN;
+
+		visibility.add(meshGND).add(meshTree, NOTUSE, MASKMAIN);
+		for (int32 i = 0; i < 7; i++) visibility.add(pixieMeshes[ST_TONAKI_A + i], 0);
+		visibility.add(meshSled, 0).add(meshCamera, NOTUSE, MASKMAIN);
+
+		//固定刻みのシミュレーション。動くメッシュはティック間を補間して描く
+		scheduler.reset();
+		history = PixieTransformHistory{};
+		for (int32 i = 0; i < 7; i++) history.add(pixieMeshes[ST_TONAKI_A + i]);
+		history.add(meshSled).add(meshCamera);
+
+		//1ティック分の更新のジョブグラフ。トナカイと雪はそれぞれ独立、カメラはソリの後
+		tickGraph.clear();
+		tickGraph.addParallel(7, 1, [this](size_t begin, size_t end)
+		{
+			for (size_t i = begin; i < end; i++)
+			{
+				updateTonakai(pixieMeshes[ST_TONAKI_A + i], lineString3D, progressPos, (uint32)i);
+				pixieMeshes[ST_TONAKI_A + i].nextFrame(0);
+			}
+		});
+		const auto jobSled = tickGraph.add([this]
+		{
+			updateSled(pixieMeshes[ST_SLED], lineString3D, progressPos);
+			pixieMeshes[ST_SLED].nextFrame(0);
+		});
+		tickGraph.add([this] { updateCamera(pixieMeshes[ST_SLED], pixieMeshes[ST_CAMERA], cameraInput); }, { jobSled });
+
+		//雪は生成と寿命を済ませてから、容量をチャンクに分けて更新する(生存数を超えたチャンクは何もしない)
+		const auto jobSnowSpawn = tickGraph.add([this] { spawnSnowFrake(lineString3D); });
+		tickGraph.addParallel(snowParticles.capacity(), SNOWGRAIN, [this](size_t begin, size_t end)
+		{
+			updateSnowFrake(lineString3D, progressPos, begin, end);
+		}, { jobSnowSpawn });
+
+		//描画前の補間と可視判定。出来た描画リストを描画に渡す
+		visibilityGraph.clear();
+		const auto jobInterpolate = visibilityGraph.add([this]
+		{
+			history.interpolate(scheduler.getAlpha());
+			visibility.beginUpdate();
+		});
+		const auto jobCull = visibilityGraph.addParallel(visibility.getEntries().size(), 16,
+			[this](size_t begin, size_t end) { visibility.cull(begin, end); }, { jobInterpolate });
+		visibilityGraph.add([this] { visibility.endUpdate(); }, { jobCull });
+	}
+
+	//経過時間分のティックを進める。戻り値は進めたティック数
+	int32 update(PixieJobs& jobs, double deltaTime)
+	{
+		//ジョブのスレッドからエンジンを読まないように、入力はここで取る
+		cameraInput = sampleCameraInput();
+
+		return scheduler.update(deltaTime, [&](uint64)
+		{
+			PIXIE_PROFILE("XMasScene::tick");
+			history.beginTick();
+			jobs.run(tickGraph);
+			history.endTick();
+
+			progressPos += TONAKAISPEED;
+		});
+	}
+
+	//描画前の補間と可視判定
+	void updateVisibility(PixieJobs& jobs)
+	{
+		PIXIE_PROFILE("XMasScene::visibility");
+		jobs.run(visibilityGraph);
+	}
+
+	//ビューを描く。レンダーターゲットとカメラの設定は呼び出し側。メインには雪も描く
+	void draw(int32 view)
+	{
+		visibility.draw(view);
+		if (view != VIEWMAIN) return;
+
+		drawSnowFrake(pixieMeshes[ST_FONT], cameraMain);
+	}
+};